@@ -28,6 +28,9 @@
 #include "cobiwm-surface-actor-x11.h"
 
 #include <X11/extensions/Xcomposite.h>
+#include <X11/Xlib-xcb.h>
+#include <xcb/composite.h>
+#include <xcb/damage.h>
 #include <cogl/cogl-texture-pixmap-x11.h>
 
 #include <errors.h>
@@ -46,6 +49,12 @@ struct _CobiwmSurfaceActorX11Private
   Pixmap pixmap;
   Damage damage;
 
+  /* Named with cobiwm_surface_actor_x11_request_pixmap(), but not
+   * checked yet
+   */
+  Pixmap pending_pixmap;
+  xcb_void_cookie_t pending_pixmap_cookie;
+
   int last_width;
   int last_height;
 
@@ -79,6 +88,27 @@ free_damage (CobiwmSurfaceActorX11 *self)
   cobiwm_error_trap_pop (display);
 }
 
+static void
+discard_pending_pixmap (CobiwmSurfaceActorX11 *self)
+{
+  CobiwmSurfaceActorX11Private *priv = cobiwm_surface_actor_x11_get_instance_private (self);
+  CobiwmDisplay *display = priv->display;
+  Display *xdisplay = cobiwm_display_get_xdisplay (display);
+
+  if (priv->pending_pixmap == None)
+    return;
+
+  /* The pixmap only exists if naming it worked, but there's no need to
+   * wait to find out whether it did.
+   */
+  cobiwm_error_ignore_cookie (display, priv->pending_pixmap_cookie);
+
+  cobiwm_error_trap_push (display);
+  XFreePixmap (xdisplay, priv->pending_pixmap);
+  priv->pending_pixmap = None;
+  cobiwm_error_trap_pop (display);
+}
+
 static void
 detach_pixmap (CobiwmSurfaceActorX11 *self)
 {
@@ -87,6 +117,8 @@ detach_pixmap (CobiwmSurfaceActorX11 *self)
   Display *xdisplay = cobiwm_display_get_xdisplay (display);
   CobiwmShapedTexture *stex = cobiwm_surface_actor_get_texture (COBIWM_SURFACE_ACTOR (self));
 
+  discard_pending_pixmap (self);
+
   if (priv->pixmap == None)
     return;
 
@@ -133,12 +165,21 @@ set_pixmap (CobiwmSurfaceActorX11 *self,
   cobiwm_shaped_texture_set_texture (stex, texture);
 }
 
-static void
-update_pixmap (CobiwmSurfaceActorX11 *self)
+/**
+ * cobiwm_surface_actor_x11_request_pixmap:
+ * @self: a #CobiwmSurfaceActorX11
+ *
+ * Names a new pixmap for the window if it needs one, without waiting to
+ * hear whether that worked; the next pre-paint picks it up.  Doing this
+ * for all the windows before any of them are painted means that finding
+ * out about all of them only takes one round trip.
+ */
+void
+cobiwm_surface_actor_x11_request_pixmap (CobiwmSurfaceActorX11 *self)
 {
   CobiwmSurfaceActorX11Private *priv = cobiwm_surface_actor_x11_get_instance_private (self);
-  CobiwmDisplay *display = priv->display;
-  Display *xdisplay = cobiwm_display_get_xdisplay (display);
+  xcb_connection_t *xcb_conn;
+  Window xwindow;
 
   if (priv->size_changed)
     {
@@ -146,15 +187,33 @@ update_pixmap (CobiwmSurfaceActorX11 *self)
       priv->size_changed = FALSE;
     }
 
-  if (priv->pixmap == None)
+  if (priv->pixmap != None || priv->pending_pixmap != None)
+    return;
+
+  xcb_conn = XGetXCBConnection (cobiwm_display_get_xdisplay (priv->display));
+  xwindow = cobiwm_window_x11_get_toplevel_xwindow (priv->window);
+
+  priv->pending_pixmap = xcb_generate_id (xcb_conn);
+  priv->pending_pixmap_cookie =
+    xcb_composite_name_window_pixmap_checked (xcb_conn, xwindow,
+                                              priv->pending_pixmap);
+}
+
+static void
+update_pixmap (CobiwmSurfaceActorX11 *self)
+{
+  CobiwmSurfaceActorX11Private *priv = cobiwm_surface_actor_x11_get_instance_private (self);
+  CobiwmDisplay *display = priv->display;
+
+  cobiwm_surface_actor_x11_request_pixmap (self);
+
+  if (priv->pending_pixmap != None)
     {
-      Pixmap new_pixmap;
-      Window xwindow = cobiwm_window_x11_get_toplevel_xwindow (priv->window);
+      Pixmap new_pixmap = priv->pending_pixmap;
 
-      cobiwm_error_trap_push (display);
-      new_pixmap = XCompositeNameWindowPixmap (xdisplay, xwindow);
+      priv->pending_pixmap = None;
 
-      if (cobiwm_error_trap_pop_with_return (display) != Success)
+      if (cobiwm_error_check_cookie (display, priv->pending_pixmap_cookie) != Success)
         {
           /* Probably a BadMatch if the window isn't viewable; we could
            * GrabServer/GetWindowAttributes/NameWindowPixmap/UngrabServer/Sync
@@ -222,13 +281,13 @@ cobiwm_surface_actor_x11_pre_paint (CobiwmSurfaceActor *actor)
   CobiwmSurfaceActorX11 *self = COBIWM_SURFACE_ACTOR_X11 (actor);
   CobiwmSurfaceActorX11Private *priv = cobiwm_surface_actor_x11_get_instance_private (self);
   CobiwmDisplay *display = priv->display;
-  Display *xdisplay = cobiwm_display_get_xdisplay (display);
+  xcb_connection_t *xcb_conn = XGetXCBConnection (cobiwm_display_get_xdisplay (display));
 
   if (priv->received_damage)
     {
-      cobiwm_error_trap_push (display);
-      XDamageSubtract (xdisplay, priv->damage, None, None);
-      cobiwm_error_trap_pop (display);
+      cobiwm_error_ignore_cookie (display,
+                                xcb_damage_subtract_checked (xcb_conn, priv->damage,
+                                                             XCB_NONE, XCB_NONE));
 
       priv->received_damage = FALSE;
     }
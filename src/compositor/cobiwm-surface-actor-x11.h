@@ -64,6 +64,8 @@ CobiwmSurfaceActor * cobiwm_surface_actor_x11_new (CobiwmWindow *window);
 void cobiwm_surface_actor_x11_set_size (CobiwmSurfaceActorX11 *self,
                                       int width, int height);
 
+void cobiwm_surface_actor_x11_request_pixmap (CobiwmSurfaceActorX11 *self);
+
 G_END_DECLS
 
 #endif /* __COBIWM_SURFACE_ACTOR_X11_H__ */
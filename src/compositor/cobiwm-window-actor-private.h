@@ -22,6 +22,7 @@ void cobiwm_window_actor_hide (CobiwmWindowActor *self,
 void cobiwm_window_actor_process_x11_damage (CobiwmWindowActor    *self,
                                            XDamageNotifyEvent *event);
 
+void cobiwm_window_actor_prepare_paint  (CobiwmWindowActor    *self);
 void cobiwm_window_actor_pre_paint      (CobiwmWindowActor    *self);
 void cobiwm_window_actor_post_paint     (CobiwmWindowActor    *self);
 void cobiwm_window_actor_frame_complete (CobiwmWindowActor    *self,
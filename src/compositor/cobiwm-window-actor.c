@@ -71,6 +71,19 @@ struct _CobiwmWindowActorPrivate
   /* The region we should clip to when painting the shadow */
   cairo_region_t   *shadow_clip;
 
+  /* The last mask built by build_and_scan_frame_mask(), the shape and
+   * frame state it was built from and the visible frame area it found
+   */
+  CoglTexture      *mask_texture;
+  cairo_region_t   *mask_shape_region;
+  cairo_region_t   *mask_frame_region;
+  cairo_rectangle_int_t mask_client_area;
+  guint             mask_tex_width;
+  guint             mask_tex_height;
+  CobiwmFrameFlags    mask_frame_flags;
+  guint             mask_style_serial;
+  gboolean          mask_has_frame;
+
   /* Extracted size-invariant shape used for shadows */
   CobiwmWindowShape  *shadow_shape;
   char *            shadow_class;
@@ -474,6 +487,9 @@ cobiwm_window_actor_dispose (GObject *object)
   g_clear_pointer (&priv->focused_shadow, cobiwm_shadow_unref);
   g_clear_pointer (&priv->unfocused_shadow, cobiwm_shadow_unref);
   g_clear_pointer (&priv->shadow_shape, cobiwm_window_shape_unref);
+  g_clear_pointer (&priv->mask_texture, cogl_object_unref);
+  g_clear_pointer (&priv->mask_shape_region, cairo_region_destroy);
+  g_clear_pointer (&priv->mask_frame_region, cairo_region_destroy);
 
   compositor->windows = g_list_remove (compositor->windows, (gconstpointer) self);
 
@@ -1666,19 +1682,61 @@ build_and_scan_frame_mask (CobiwmWindowActor       *self,
   int stride;
   cairo_t *cr;
   cairo_surface_t *surface;
+  CobiwmFrameFlags frame_flags;
+  guint style_serial;
+  gboolean has_frame;
 
   stex = cobiwm_surface_actor_get_texture (priv->surface);
   g_return_if_fail (stex);
 
-  cobiwm_shaped_texture_set_mask_texture (stex, NULL);
-
   paint_tex = cobiwm_shaped_texture_get_texture (stex);
   if (paint_tex == NULL)
-    return;
+    {
+      cobiwm_shaped_texture_set_mask_texture (stex, NULL);
+      return;
+    }
 
   tex_width = cogl_texture_get_width (paint_tex);
   tex_height = cogl_texture_get_height (paint_tex);
 
+  has_frame = priv->window->frame != NULL;
+  frame_flags = has_frame ? cobiwm_frame_get_flags (priv->window->frame) : 0;
+  style_serial = has_frame ? cobiwm_frame_get_style_serial (priv->window->frame) : 0;
+
+  /* Input and opaque region changes reshape the window too, but don't
+   * change the mask; building it means rendering and scanning the whole
+   * frame and uploading a texture the size of the window, so reuse the
+   * last one when nothing it depends on changed.
+   */
+  if (priv->mask_texture != NULL &&
+      priv->mask_tex_width == tex_width &&
+      priv->mask_tex_height == tex_height &&
+      priv->mask_has_frame == has_frame &&
+      priv->mask_frame_flags == frame_flags &&
+      priv->mask_style_serial == style_serial &&
+      gdk_rectangle_equal (&priv->mask_client_area, client_area) &&
+      cairo_region_equal (priv->mask_shape_region, shape_region))
+    {
+      cobiwm_shaped_texture_set_mask_texture (stex, priv->mask_texture);
+      if (priv->mask_frame_region)
+        cairo_region_union (shape_region, priv->mask_frame_region);
+      return;
+    }
+
+  g_clear_pointer (&priv->mask_texture, cogl_object_unref);
+  g_clear_pointer (&priv->mask_shape_region, cairo_region_destroy);
+  g_clear_pointer (&priv->mask_frame_region, cairo_region_destroy);
+
+  priv->mask_shape_region = cairo_region_copy (shape_region);
+  priv->mask_client_area = *client_area;
+  priv->mask_tex_width = tex_width;
+  priv->mask_tex_height = tex_height;
+  priv->mask_has_frame = has_frame;
+  priv->mask_frame_flags = frame_flags;
+  priv->mask_style_serial = style_serial;
+
+  cobiwm_shaped_texture_set_mask_texture (stex, NULL);
+
   stride = cairo_format_stride_for_width (CAIRO_FORMAT_A8, tex_width);
 
   /* Create data for an empty image */
@@ -1711,7 +1769,7 @@ build_and_scan_frame_mask (CobiwmWindowActor       *self,
       cairo_surface_flush (surface);
       scanned_region = scan_visible_region (mask_data, stride, frame_paint_region);
       cairo_region_union (shape_region, scanned_region);
-      cairo_region_destroy (scanned_region);
+      priv->mask_frame_region = scanned_region;
       cairo_region_destroy (frame_paint_region);
     }
 
@@ -1746,8 +1804,7 @@ build_and_scan_frame_mask (CobiwmWindowActor       *self,
     }
 
   cobiwm_shaped_texture_set_mask_texture (stex, mask_texture);
-  if (mask_texture)
-    cogl_object_unref (mask_texture);
+  priv->mask_texture = mask_texture;
 
   g_free (mask_data);
 }
@@ -1904,6 +1961,22 @@ cobiwm_window_actor_handle_updates (CobiwmWindowActor *self)
   check_needs_shadow (self);
 }
 
+/* Makes the requests cobiwm_window_actor_pre_paint() will need the
+ * results of, so that they can be made for all the windows in one go.
+ */
+void
+cobiwm_window_actor_prepare_paint (CobiwmWindowActor *self)
+{
+  CobiwmWindowActorPrivate *priv = self->priv;
+
+  if (cobiwm_window_actor_is_destroyed (self) || is_frozen (self))
+    return;
+
+  if (COBIWM_IS_SURFACE_ACTOR_X11 (priv->surface) &&
+      !cobiwm_surface_actor_is_unredirected (priv->surface))
+    cobiwm_surface_actor_x11_request_pixmap (COBIWM_SURFACE_ACTOR_X11 (priv->surface));
+}
+
 void
 cobiwm_window_actor_pre_paint (CobiwmWindowActor *self)
 {
@@ -936,6 +936,9 @@ cobiwm_pre_paint_func (gpointer data)
   else
     set_unredirected_window (compositor, NULL);
 
+  for (l = compositor->windows; l; l = l->next)
+    cobiwm_window_actor_prepare_paint (l->data);
+
   for (l = compositor->windows; l; l = l->next)
     cobiwm_window_actor_pre_paint (l->data);
 
@@ -42,6 +42,7 @@ typedef enum
  *   rect_to_string:   RECT_LENGTH
  *   region_to_string: (RECT_LENGTH+strlen(separator_string)) *
  *                     g_list_length (region)
+ *   region_array_...: (RECT_LENGTH+strlen(separator_string)) * region->len
  *   edge_to_string:   EDGE_LENGTH
  *   edge_list_to_...: (EDGE_LENGTH+strlen(separator_string)) *
  *                     g_list_length (edge_list)
@@ -53,6 +54,10 @@ char* cobiwm_rectangle_to_string        (const CobiwmRectangle *rect,
 char* cobiwm_rectangle_region_to_string (GList               *region,
                                        const char          *separator_string,
                                        char                *output);
+char* cobiwm_rectangle_region_array_to_string (
+                                       const GArray        *region,
+                                       const char          *separator_string,
+                                       char                *output);
 char* cobiwm_rectangle_edge_to_string   (const CobiwmEdge      *edge,
                                        char                *output);
 char* cobiwm_rectangle_edge_list_to_string (
@@ -88,6 +93,20 @@ GList*   cobiwm_rectangle_get_minimal_spanning_set_for_region (
                                          const CobiwmRectangle *basic_rect,
                                          const GSList        *all_struts);
 
+/* Same as above, but returns the region as a GArray of CobiwmRectangle
+ * stored by value, in the same order; free it with g_array_free().  This
+ * is what the constraints code uses, as it avoids an allocation per
+ * rectangle and keeps the region contiguous for the queries below.
+ */
+GArray*  cobiwm_rectangle_get_minimal_spanning_array_for_region (
+                                         const CobiwmRectangle *basic_rect,
+                                         const GSList        *all_struts);
+
+/* Copy a region array into a list that can be freed with
+ * cobiwm_rectangle_free_list_and_elements().
+ */
+GList*   cobiwm_rectangle_region_array_to_list (const GArray *region);
+
 /* Expand all rectangles in region by the given amount on each side */
 GList*   cobiwm_rectangle_expand_region   (GList               *region,
                                          const int            left_expand,
@@ -105,6 +124,14 @@ GList*   cobiwm_rectangle_expand_region_conditionally (
                                          const int            bottom_expand,
                                          const int            min_x,
                                          const int            min_y);
+void     cobiwm_rectangle_expand_region_array_conditionally (
+                                         GArray               *region,
+                                         const int            left_expand,
+                                         const int            right_expand,
+                                         const int            top_expand,
+                                         const int            bottom_expand,
+                                         const int            min_x,
+                                         const int            min_y);
 
 /* Expand rect in direction to the size of expand_to, and then clip out any
  * overlapping struts oriented orthognal to the expansion direction.  (Think
@@ -163,6 +190,33 @@ void     cobiwm_rectangle_shove_into_region(
                                          FixedDirections      fixed_directions,
                                          CobiwmRectangle       *rect);
 
+/* Variants of the region functions above for regions stored in a GArray,
+ * as returned by cobiwm_rectangle_get_minimal_spanning_array_for_region().
+ * A NULL region is treated as empty.
+ */
+gboolean cobiwm_rectangle_could_fit_in_region_array (
+                                         const GArray        *region,
+                                         const CobiwmRectangle *rect);
+gboolean cobiwm_rectangle_contained_in_region_array (
+                                         const GArray        *region,
+                                         const CobiwmRectangle *rect);
+gboolean cobiwm_rectangle_overlaps_with_region_array (
+                                         const GArray        *region,
+                                         const CobiwmRectangle *rect);
+void     cobiwm_rectangle_clamp_to_fit_into_region_array (
+                                         const GArray        *region,
+                                         FixedDirections      fixed_directions,
+                                         CobiwmRectangle       *rect,
+                                         const CobiwmRectangle *min_size);
+void     cobiwm_rectangle_clip_to_region_array (
+                                         const GArray        *region,
+                                         FixedDirections      fixed_directions,
+                                         CobiwmRectangle       *rect);
+void     cobiwm_rectangle_shove_into_region_array (
+                                         const GArray        *region,
+                                         FixedDirections      fixed_directions,
+                                         CobiwmRectangle       *rect);
+
 /* Finds the point on the line connecting (x1,y1) to (x2,y2) which is closest
  * to (px, py).  Useful for finding an optimal rectangle size when given a
  * range between two sizes that are all candidates.
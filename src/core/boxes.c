@@ -107,6 +107,31 @@ cobiwm_rectangle_region_to_string (GList      *region,
   return output;
 }
 
+char*
+cobiwm_rectangle_region_array_to_string (const GArray *region,
+                                       const char   *separator_string,
+                                       char         *output)
+{
+  char rect_string[RECT_LENGTH];
+  char *cur = output;
+  guint i;
+
+  if (region == NULL || region->len == 0)
+    g_snprintf (output, 10, "(EMPTY)");
+
+  for (i = 0; region && i < region->len; i++)
+    {
+      const CobiwmRectangle *rect = &g_array_index (region, CobiwmRectangle, i);
+      g_snprintf (rect_string, RECT_LENGTH, "[%d,%d +%d,%d]",
+                  rect->x, rect->y, rect->width, rect->height);
+      cur = g_stpcpy (cur, rect_string);
+      if (i + 1 < region->len)
+        cur = g_stpcpy (cur, separator_string);
+    }
+
+  return output;
+}
+
 char*
 cobiwm_rectangle_edge_to_string (const CobiwmEdge *edge,
                                char           *output)
@@ -424,126 +449,105 @@ cobiwm_rectangle_resize_with_gravity (const CobiwmRectangle *old_rect,
 }
 
 /* Not so simple helper function for get_minimal_spanning_set_for_region() */
-static GList*
-merge_spanning_rects_in_region (GList *region)
+static void
+merge_spanning_rects_in_region (GArray *region)
 {
   /* NOTE FOR ANY OPTIMIZATION PEOPLE OUT THERE: Please see the
    * documentation of get_minimal_spanning_set_for_region() for performance
    * considerations that also apply to this function.
    */
 
-  GList* compare;
-  compare = region;
+  guint compare;
 
-  if (region == NULL)
+  if (region->len == 0)
     {
       cobiwm_warning ("Region to merge was empty!  Either you have a some "
                     "pathological STRUT list or there's a bug somewhere!\n");
-      return NULL;
+      return;
     }
 
-  while (compare && compare->next)
+  for (compare = 0; compare + 1 < region->len; compare++)
     {
-      CobiwmRectangle *a = compare->data;
-      GList *other = compare->next;
+      CobiwmRectangle *a = &g_array_index (region, CobiwmRectangle, compare);
+      guint other = compare + 1;
 
       g_assert (a->width > 0 && a->height > 0);
 
-      while (other)
+      while (other < region->len)
         {
-          CobiwmRectangle *b = other->data;
-          GList *delete_me = NULL;
+          CobiwmRectangle *b = &g_array_index (region, CobiwmRectangle, other);
+          gboolean delete_b = FALSE;
 
           g_assert (b->width > 0 && b->height > 0);
 
           /* If a contains b, just remove b */
           if (cobiwm_rectangle_contains_rect (a, b))
             {
-              delete_me = other;
+              delete_b = TRUE;
             }
-          /* If b contains a, just remove a */
-          else if (cobiwm_rectangle_contains_rect (a, b))
+          /* If b contains a, a takes b's place and b goes away */
+          else if (cobiwm_rectangle_contains_rect (b, a))
             {
-              delete_me = compare;
+              *a = *b;
+              delete_b = TRUE;
             }
           /* If a and b might be mergeable horizontally */
           else if (a->y == b->y && a->height == b->height)
             {
-              /* If a and b overlap */
-              if (cobiwm_rectangle_overlap (a, b))
-                {
-                  int new_x = MIN (a->x, b->x);
-                  a->width = MAX (a->x + a->width, b->x + b->width) - new_x;
-                  a->x = new_x;
-                  delete_me = other;
-                }
-              /* If a and b are adjacent */
-              else if (a->x + a->width == b->x || a->x == b->x + b->width)
+              /* If a and b overlap or are adjacent */
+              if (cobiwm_rectangle_overlap (a, b) ||
+                  a->x + a->width == b->x || a->x == b->x + b->width)
                 {
                   int new_x = MIN (a->x, b->x);
                   a->width = MAX (a->x + a->width, b->x + b->width) - new_x;
                   a->x = new_x;
-                  delete_me = other;
+                  delete_b = TRUE;
                 }
             }
           /* If a and b might be mergeable vertically */
           else if (a->x == b->x && a->width == b->width)
             {
-              /* If a and b overlap */
-              if (cobiwm_rectangle_overlap (a, b))
+              /* If a and b overlap or are adjacent */
+              if (cobiwm_rectangle_overlap (a, b) ||
+                  a->y + a->height == b->y || a->y == b->y + b->height)
                 {
                   int new_y = MIN (a->y, b->y);
                   a->height = MAX (a->y + a->height, b->y + b->height) - new_y;
                   a->y = new_y;
-                  delete_me = other;
+                  delete_b = TRUE;
                 }
-              /* If a and b are adjacent */
-              else if (a->y + a->height == b->y || a->y == b->y + b->height)
-                {
-                  int new_y = MIN (a->y, b->y);
-                  a->height = MAX (a->y + a->height, b->y + b->height) - new_y;
-                  a->y = new_y;
-                  delete_me = other;
-                }
-            }
-
-          other = other->next;
-
-          /* Delete any rectangle in the list that is no longer wanted */
-          if (delete_me != NULL)
-            {
-              /* Deleting the rect we compare others to is a little tricker */
-              if (compare == delete_me)
-                {
-                  compare = compare->next;
-                  other = compare->next;
-                  a = compare->data;
-                }
-
-              /* Okay, we can free it now */
-              g_free (delete_me->data);
-              region = g_list_delete_link (region, delete_me);
             }
 
+          /* Removing keeps the order of the remaining rectangles, and
+           * never reallocates, so a stays valid.
+           */
+          if (delete_b)
+            g_array_remove_index (region, other);
+          else
+            other++;
         }
-
-      compare = compare->next;
     }
-
-  return region;
 }
 
 /* Simple helper function for get_minimal_spanning_set_for_region()... */
-static gint
-compare_rect_areas (gconstpointer a, gconstpointer b)
+static void
+sort_rects_by_area (GArray *region)
 {
-  const CobiwmRectangle *a_rect = (gconstpointer) a;
-  const CobiwmRectangle *b_rect = (gconstpointer) b;
+  /* Largest first.  The region is tiny and this needs to be a stable
+   * sort, so a plain insertion sort does just fine.
+   */
+  CobiwmRectangle *rects = (CobiwmRectangle *) region->data;
+  guint i, j;
 
-  int a_area = cobiwm_rectangle_area (a_rect);
-  int b_area = cobiwm_rectangle_area (b_rect);
+  for (i = 1; i < region->len; i++)
+    {
+      CobiwmRectangle tmp = rects[i];
+      int area = cobiwm_rectangle_area (&tmp);
 
-  return b_area - a_area; /* positive ret value denotes b > a, ... */
+      for (j = i; j > 0 && cobiwm_rectangle_area (&rects[j - 1]) < area; j--)
+        rects[j] = rects[j - 1];
+      rects[j] = tmp;
+    }
 }
 
 /* ... and another helper for get_minimal_spanning_set_for_region()... */
@@ -567,52 +571,42 @@ check_strut_align (CobiwmStrut *strut, const CobiwmRectangle *rect)
 }
 
 /**
- * cobiwm_rectangle_get_minimal_spanning_set_for_region:
+ * cobiwm_rectangle_get_minimal_spanning_array_for_region: (skip)
  * @basic_rect: Input rectangle
  * @all_struts: (element-type Cobiwm.Rectangle): List of struts
  *
- * This function is trying to find a "minimal spanning set (of rectangles)"
- * for a given region.
+ * Array based version of
+ * cobiwm_rectangle_get_minimal_spanning_set_for_region(), see there.
  *
- * The region is given by taking basic_rect, then removing the areas
- * covered by all the rectangles in the all_struts list, and then expanding
- * the resulting region by the given number of pixels in each direction.
- *
- * A "minimal spanning set (of rectangles)" is the best name I could come
- * up with for the concept I had in mind.  Basically, for a given region, I
- * want a set of rectangles with the property that a window is contained in
- * the region if and only if it is contained within at least one of the
- * rectangles.
- *
- * Returns: (transfer full) (element-type Cobiwm.Rectangle): Minimal spanning set
+ * Returns: a #GArray of #CobiwmRectangle, free with g_array_free()
  */
-GList*
-cobiwm_rectangle_get_minimal_spanning_set_for_region (
+GArray*
+cobiwm_rectangle_get_minimal_spanning_array_for_region (
   const CobiwmRectangle *basic_rect,
-  const GSList  *all_struts)
+  const GSList        *all_struts)
 {
   /* NOTE FOR OPTIMIZERS: This function *might* be somewhat slow,
    * especially due to the call to merge_spanning_rects_in_region() (which
-   * is O(n^2) where n is the size of the list generated in this function).
-   * This is made more onerous due to the fact that it involves a fair
-   * number of memory allocation and deallocation calls.  However, n is 1
-   * for default installations of Gnome (because partial struts aren't used
-   * by default and only partial struts increase the size of the spanning
-   * set generated).  With one partial strut, n will be 2 or 3.  With 2
-   * partial struts, n will probably be 4 or 5.  So, n probably isn't large
-   * enough to make this worth bothering.  Further, it is only called from
-   * workspace.c:ensure_work_areas_validated (at least as of the time of
-   * writing this comment), which in turn should only be called if the
-   * strut list changes or the screen or monitor size changes.  If it ever
-   * does show up on profiles (most likely because people start using
-   * ridiculously huge numbers of partial struts), possible optimizations
-   * include:
+   * is O(n^2) where n is the size of the array generated in this function).
+   * However, n is 1 for default installations of Gnome (because partial
+   * struts aren't used by default and only partial struts increase the
+   * size of the spanning set generated).  With one partial strut, n will
+   * be 2 or 3.  With 2 partial struts, n will probably be 4 or 5.  So, n
+   * probably isn't large enough to make this worth bothering.  It is only
+   * called from workspace.c:ensure_work_areas_validated (at least as of
+   * the time of writing this comment), which in turn should only be
+   * called if the strut list changes or the screen or monitor size
+   * changes.  The rectangles are kept by value in two arrays which are
+   * swapped for every strut, so the only allocations are the two arrays.
+   * If it ever does show up on profiles (most likely because people start
+   * using ridiculously huge numbers of partial struts), possible
+   * optimizations include:
    *
    * (1) rewrite merge_spanning_rects_in_region() to be O(n) or O(nlogn).
    *     I'm not totally sure it's possible, but with a couple copies of
-   *     the list and sorting them appropriately, I believe it might be.
+   *     the array and sorting them appropriately, I believe it might be.
    * (2) only call merge_spanning_rects_in_region() with a subset of the
-   *     full list of rectangles.  I believe from some of my preliminary
+   *     full array of rectangles.  I believe from some of my preliminary
    *     debugging and thinking about it that it is possible to figure out
    *     apriori groups of rectangles which are only merge candidates with
    *     each other.  (See testboxes.c:get_screen_region() when which==2
@@ -627,10 +621,10 @@ cobiwm_rectangle_get_minimal_spanning_set_for_region (
    *     URL splitting.)
    */
 
-  GList         *ret;
-  GList         *tmp_list;
+  GArray        *ret;
+  GArray        *scratch;
   const GSList  *strut_iter;
-  CobiwmRectangle *temp_rect;
+  guint          i;
 
   /* The algorithm is basically as follows:
    *   Initialize rectangle_set to basic_rect
@@ -641,80 +635,127 @@ cobiwm_rectangle_get_minimal_spanning_set_for_region (
    *       - Remove the old (pre-split) rectangle from the rectangle_set,
    *         and replace it with the new rectangles generated from the
    *         splitting
+   *
+   * Every pass reverses the order of the rectangles (which matters for
+   * the stable sort at the end), so walk the previous set backwards.
    */
 
-  temp_rect = g_new (CobiwmRectangle, 1);
-  *temp_rect = *basic_rect;
-  ret = g_list_prepend (NULL, temp_rect);
+  ret     = g_array_sized_new (FALSE, FALSE, sizeof (CobiwmRectangle), 8);
+  scratch = g_array_sized_new (FALSE, FALSE, sizeof (CobiwmRectangle), 8);
+  g_array_append_vals (ret, basic_rect, 1);
 
   for (strut_iter = all_struts; strut_iter; strut_iter = strut_iter->next)
     {
-      GList *rect_iter;
       CobiwmStrut *strut = (CobiwmStrut*)strut_iter->data;
       CobiwmRectangle *strut_rect = &strut->rect;
+      GArray *tmp;
 
-      tmp_list = ret;
-      ret = NULL;
-      rect_iter = tmp_list;
-      while (rect_iter)
+      g_array_set_size (scratch, 0);
+      for (i = ret->len; i > 0; i--)
         {
-          CobiwmRectangle *rect = (CobiwmRectangle*) rect_iter->data;
+          CobiwmRectangle rect = g_array_index (ret, CobiwmRectangle, i - 1);
+          CobiwmRectangle temp_rect;
 
-          if (!cobiwm_rectangle_overlap (strut_rect, rect) ||
+          if (!cobiwm_rectangle_overlap (strut_rect, &rect) ||
               !check_strut_align (strut, basic_rect))
-            ret = g_list_prepend (ret, rect);
-          else
             {
-              /* If there is area in rect left of strut */
-              if (BOX_LEFT (*rect) < BOX_LEFT (*strut_rect))
-                {
-                  temp_rect = g_new (CobiwmRectangle, 1);
-                  *temp_rect = *rect;
-                  temp_rect->width = BOX_LEFT (*strut_rect) - BOX_LEFT (*rect);
-                  ret = g_list_prepend (ret, temp_rect);
-                }
-              /* If there is area in rect right of strut */
-              if (BOX_RIGHT (*rect) > BOX_RIGHT (*strut_rect))
-                {
-                  int new_x;
-                  temp_rect = g_new (CobiwmRectangle, 1);
-                  *temp_rect = *rect;
-                  new_x = BOX_RIGHT (*strut_rect);
-                  temp_rect->width = BOX_RIGHT(*rect) - new_x;
-                  temp_rect->x = new_x;
-                  ret = g_list_prepend (ret, temp_rect);
-                }
-              /* If there is area in rect above strut */
-              if (BOX_TOP (*rect) < BOX_TOP (*strut_rect))
-                {
-                  temp_rect = g_new (CobiwmRectangle, 1);
-                  *temp_rect = *rect;
-                  temp_rect->height = BOX_TOP (*strut_rect) - BOX_TOP (*rect);
-                  ret = g_list_prepend (ret, temp_rect);
-                }
-              /* If there is area in rect below strut */
-              if (BOX_BOTTOM (*rect) > BOX_BOTTOM (*strut_rect))
-                {
-                  int new_y;
-                  temp_rect = g_new (CobiwmRectangle, 1);
-                  *temp_rect = *rect;
-                  new_y = BOX_BOTTOM (*strut_rect);
-                  temp_rect->height = BOX_BOTTOM (*rect) - new_y;
-                  temp_rect->y = new_y;
-                  ret = g_list_prepend (ret, temp_rect);
-                }
-              g_free (rect);
+              g_array_append_val (scratch, rect);
+              continue;
+            }
+
+          /* If there is area in rect left of strut */
+          if (BOX_LEFT (rect) < BOX_LEFT (*strut_rect))
+            {
+              temp_rect = rect;
+              temp_rect.width = BOX_LEFT (*strut_rect) - BOX_LEFT (rect);
+              g_array_append_val (scratch, temp_rect);
+            }
+          /* If there is area in rect right of strut */
+          if (BOX_RIGHT (rect) > BOX_RIGHT (*strut_rect))
+            {
+              int new_x;
+              temp_rect = rect;
+              new_x = BOX_RIGHT (*strut_rect);
+              temp_rect.width = BOX_RIGHT (rect) - new_x;
+              temp_rect.x = new_x;
+              g_array_append_val (scratch, temp_rect);
+            }
+          /* If there is area in rect above strut */
+          if (BOX_TOP (rect) < BOX_TOP (*strut_rect))
+            {
+              temp_rect = rect;
+              temp_rect.height = BOX_TOP (*strut_rect) - BOX_TOP (rect);
+              g_array_append_val (scratch, temp_rect);
+            }
+          /* If there is area in rect below strut */
+          if (BOX_BOTTOM (rect) > BOX_BOTTOM (*strut_rect))
+            {
+              int new_y;
+              temp_rect = rect;
+              new_y = BOX_BOTTOM (*strut_rect);
+              temp_rect.height = BOX_BOTTOM (rect) - new_y;
+              temp_rect.y = new_y;
+              g_array_append_val (scratch, temp_rect);
             }
-          rect_iter = rect_iter->next;
         }
-      g_list_free (tmp_list);
+
+      tmp = ret;
+      ret = scratch;
+      scratch = tmp;
+    }
+  g_array_free (scratch, TRUE);
+
+  /* Undo the reversal from the last pass, see above */
+  for (i = 0; i < ret->len / 2; i++)
+    {
+      CobiwmRectangle *rects = (CobiwmRectangle *) ret->data;
+      CobiwmRectangle tmp = rects[i];
+
+      rects[i] = rects[ret->len - 1 - i];
+      rects[ret->len - 1 - i] = tmp;
     }
 
   /* Sort by maximal area, just because I feel like it... */
-  ret = g_list_sort (ret, compare_rect_areas);
+  sort_rects_by_area (ret);
+
+  /* Merge rectangles if possible so that the array really is minimal */
+  merge_spanning_rects_in_region (ret);
+
+  return ret;
+}
+
+/**
+ * cobiwm_rectangle_get_minimal_spanning_set_for_region:
+ * @basic_rect: Input rectangle
+ * @all_struts: (element-type Cobiwm.Rectangle): List of struts
+ *
+ * This function is trying to find a "minimal spanning set (of rectangles)"
+ * for a given region.
+ *
+ * The region is given by taking basic_rect, then removing the areas
+ * covered by all the rectangles in the all_struts list, and then expanding
+ * the resulting region by the given number of pixels in each direction.
+ *
+ * A "minimal spanning set (of rectangles)" is the best name I could come
+ * up with for the concept I had in mind.  Basically, for a given region, I
+ * want a set of rectangles with the property that a window is contained in
+ * the region if and only if it is contained within at least one of the
+ * rectangles.
+ *
+ * Returns: (transfer full) (element-type Cobiwm.Rectangle): Minimal spanning set
+ */
+GList*
+cobiwm_rectangle_get_minimal_spanning_set_for_region (
+  const CobiwmRectangle *basic_rect,
+  const GSList  *all_struts)
+{
+  GArray *region;
+  GList  *ret;
 
-  /* Merge rectangles if possible so that the list really is minimal */
-  ret = merge_spanning_rects_in_region (ret);
+  region = cobiwm_rectangle_get_minimal_spanning_array_for_region (basic_rect,
+                                                                 all_struts);
+  ret = cobiwm_rectangle_region_array_to_list (region);
+  g_array_free (region, TRUE);
 
   return ret;
 }
@@ -772,6 +813,33 @@ cobiwm_rectangle_expand_region_conditionally (GList     *region,
   return region;
 }
 
+void
+cobiwm_rectangle_expand_region_array_conditionally (GArray    *region,
+                                                  const int  left_expand,
+                                                  const int  right_expand,
+                                                  const int  top_expand,
+                                                  const int  bottom_expand,
+                                                  const int  min_x,
+                                                  const int  min_y)
+{
+  guint i;
+
+  for (i = 0; region && i < region->len; i++)
+    {
+      CobiwmRectangle *rect = &g_array_index (region, CobiwmRectangle, i);
+      if (rect->width >= min_x)
+        {
+          rect->x      -= left_expand;
+          rect->width  += (left_expand + right_expand);
+        }
+      if (rect->height >= min_y)
+        {
+          rect->y      -= top_expand;
+          rect->height += (top_expand + bottom_expand);
+        }
+    }
+}
+
 void
 cobiwm_rectangle_expand_to_avoiding_struts (CobiwmRectangle       *rect,
                                           const CobiwmRectangle *expand_to,
@@ -851,77 +919,151 @@ cobiwm_rectangle_free_list_and_elements (GList *filled_list)
   g_list_free (filled_list);
 }
 
+/**
+ * cobiwm_rectangle_region_array_to_list: (skip)
+ *
+ * Copies a region array into a list of separately allocated rectangles,
+ * as used by the list based region functions.  Free the result with
+ * cobiwm_rectangle_free_list_and_elements().
+ */
+GList*
+cobiwm_rectangle_region_array_to_list (const GArray *region)
+{
+  GList *ret = NULL;
+  guint  i;
+
+  if (region == NULL)
+    return NULL;
+
+  for (i = region->len; i > 0; i--)
+    ret = g_list_prepend (ret,
+                          cobiwm_rectangle_copy (&g_array_index (region,
+                                                                 CobiwmRectangle,
+                                                                 i - 1)));
+
+  return ret;
+}
+
+/* Lets the list based region functions share the array based code */
+static GArray*
+region_list_to_array (const GList *region)
+{
+  GArray *ret;
+
+  ret = g_array_new (FALSE, FALSE, sizeof (CobiwmRectangle));
+  for (; region; region = region->next)
+    g_array_append_vals (ret, region->data, 1);
+
+  return ret;
+}
+
+gboolean
+cobiwm_rectangle_could_fit_in_region_array (const GArray        *region,
+                                          const CobiwmRectangle *rect)
+{
+  guint i;
+
+  if (region == NULL)
+    return FALSE;
+
+  for (i = 0; i < region->len; i++)
+    if (cobiwm_rectangle_could_fit_rect (&g_array_index (region, CobiwmRectangle, i),
+                                       rect))
+      return TRUE;
+
+  return FALSE;
+}
+
 gboolean
 cobiwm_rectangle_could_fit_in_region (const GList         *spanning_rects,
                                     const CobiwmRectangle *rect)
 {
-  const GList *temp;
-  gboolean     could_fit;
+  GArray  *region = region_list_to_array (spanning_rects);
+  gboolean could_fit;
 
-  temp = spanning_rects;
-  could_fit = FALSE;
-  while (!could_fit && temp != NULL)
-    {
-      could_fit = could_fit || cobiwm_rectangle_could_fit_rect (temp->data, rect);
-      temp = temp->next;
-    }
+  could_fit = cobiwm_rectangle_could_fit_in_region_array (region, rect);
+  g_array_free (region, TRUE);
 
   return could_fit;
 }
 
+gboolean
+cobiwm_rectangle_contained_in_region_array (const GArray        *region,
+                                          const CobiwmRectangle *rect)
+{
+  guint i;
+
+  if (region == NULL)
+    return FALSE;
+
+  for (i = 0; i < region->len; i++)
+    if (cobiwm_rectangle_contains_rect (&g_array_index (region, CobiwmRectangle, i),
+                                      rect))
+      return TRUE;
+
+  return FALSE;
+}
+
 gboolean
 cobiwm_rectangle_contained_in_region (const GList         *spanning_rects,
                                     const CobiwmRectangle *rect)
 {
-  const GList *temp;
-  gboolean     contained;
+  GArray  *region = region_list_to_array (spanning_rects);
+  gboolean contained;
 
-  temp = spanning_rects;
-  contained = FALSE;
-  while (!contained && temp != NULL)
-    {
-      contained = contained || cobiwm_rectangle_contains_rect (temp->data, rect);
-      temp = temp->next;
-    }
+  contained = cobiwm_rectangle_contained_in_region_array (region, rect);
+  g_array_free (region, TRUE);
 
   return contained;
 }
 
+gboolean
+cobiwm_rectangle_overlaps_with_region_array (const GArray        *region,
+                                           const CobiwmRectangle *rect)
+{
+  guint i;
+
+  if (region == NULL)
+    return FALSE;
+
+  for (i = 0; i < region->len; i++)
+    if (cobiwm_rectangle_overlap (&g_array_index (region, CobiwmRectangle, i),
+                                rect))
+      return TRUE;
+
+  return FALSE;
+}
+
 gboolean
 cobiwm_rectangle_overlaps_with_region (const GList         *spanning_rects,
                                      const CobiwmRectangle *rect)
 {
-  const GList *temp;
-  gboolean     overlaps;
+  GArray  *region = region_list_to_array (spanning_rects);
+  gboolean overlaps;
 
-  temp = spanning_rects;
-  overlaps = FALSE;
-  while (!overlaps && temp != NULL)
-    {
-      overlaps = overlaps || cobiwm_rectangle_overlap (temp->data, rect);
-      temp = temp->next;
-    }
+  overlaps = cobiwm_rectangle_overlaps_with_region_array (region, rect);
+  g_array_free (region, TRUE);
 
   return overlaps;
 }
 
-
 void
-cobiwm_rectangle_clamp_to_fit_into_region (const GList         *spanning_rects,
-                                         FixedDirections      fixed_directions,
-                                         CobiwmRectangle       *rect,
-                                         const CobiwmRectangle *min_size)
+cobiwm_rectangle_clamp_to_fit_into_region_array (const GArray        *region,
+                                               FixedDirections      fixed_directions,
+                                               CobiwmRectangle       *rect,
+                                               const CobiwmRectangle *min_size)
 {
-  const GList *temp;
   const CobiwmRectangle *best_rect = NULL;
   int                  best_overlap = 0;
+  guint                i;
 
-  /* First, find best rectangle from spanning_rects to which we can clamp
+  /* First, find best rectangle from the region to which we can clamp
    * rect to fit into.
    */
-  for (temp = spanning_rects; temp; temp = temp->next)
+  for (i = 0; region && i < region->len; i++)
     {
-      CobiwmRectangle *compare_rect = temp->data;
+      const CobiwmRectangle *compare_rect =
+        &g_array_index (region, CobiwmRectangle, i);
       int            maximal_overlap_amount_for_compare;
 
       /* If x is fixed and the entire width of rect doesn't fit in compare,
@@ -977,20 +1119,34 @@ cobiwm_rectangle_clamp_to_fit_into_region (const GList         *spanning_rects,
 }
 
 void
-cobiwm_rectangle_clip_to_region (const GList         *spanning_rects,
-                               FixedDirections      fixed_directions,
-                               CobiwmRectangle       *rect)
+cobiwm_rectangle_clamp_to_fit_into_region (const GList         *spanning_rects,
+                                         FixedDirections      fixed_directions,
+                                         CobiwmRectangle       *rect,
+                                         const CobiwmRectangle *min_size)
+{
+  GArray *region = region_list_to_array (spanning_rects);
+
+  cobiwm_rectangle_clamp_to_fit_into_region_array (region, fixed_directions,
+                                                 rect, min_size);
+  g_array_free (region, TRUE);
+}
+
+void
+cobiwm_rectangle_clip_to_region_array (const GArray        *region,
+                                     FixedDirections      fixed_directions,
+                                     CobiwmRectangle       *rect)
 {
-  const GList *temp;
   const CobiwmRectangle *best_rect = NULL;
   int                  best_overlap = 0;
+  guint                i;
 
-  /* First, find best rectangle from spanning_rects to which we will clip
+  /* First, find best rectangle from the region to which we will clip
    * rect into.
    */
-  for (temp = spanning_rects; temp; temp = temp->next)
+  for (i = 0; region && i < region->len; i++)
     {
-      CobiwmRectangle *compare_rect = temp->data;
+      const CobiwmRectangle *compare_rect =
+        &g_array_index (region, CobiwmRectangle, i);
       CobiwmRectangle  overlap;
       int            maximal_overlap_amount_for_compare;
 
@@ -1054,22 +1210,34 @@ cobiwm_rectangle_clip_to_region (const GList         *spanning_rects,
 }
 
 void
-cobiwm_rectangle_shove_into_region (const GList         *spanning_rects,
-                                  FixedDirections      fixed_directions,
-                                  CobiwmRectangle       *rect)
+cobiwm_rectangle_clip_to_region (const GList         *spanning_rects,
+                               FixedDirections      fixed_directions,
+                               CobiwmRectangle       *rect)
+{
+  GArray *region = region_list_to_array (spanning_rects);
+
+  cobiwm_rectangle_clip_to_region_array (region, fixed_directions, rect);
+  g_array_free (region, TRUE);
+}
+
+void
+cobiwm_rectangle_shove_into_region_array (const GArray        *region,
+                                        FixedDirections      fixed_directions,
+                                        CobiwmRectangle       *rect)
 {
-  const GList *temp;
   const CobiwmRectangle *best_rect = NULL;
   int                  best_overlap = 0;
   int                  shortest_distance = G_MAXINT;
+  guint                i;
 
-  /* First, find best rectangle from spanning_rects to which we will shove
+  /* First, find best rectangle from the region to which we will shove
    * rect into.
    */
 
-  for (temp = spanning_rects; temp; temp = temp->next)
+  for (i = 0; region && i < region->len; i++)
     {
-      CobiwmRectangle *compare_rect = temp->data;
+      const CobiwmRectangle *compare_rect =
+        &g_array_index (region, CobiwmRectangle, i);
       int            maximal_overlap_amount_for_compare;
       int            dist_to_compare;
 
@@ -1153,6 +1321,17 @@ cobiwm_rectangle_shove_into_region (const GList         *spanning_rects,
     }
 }
 
+void
+cobiwm_rectangle_shove_into_region (const GList         *spanning_rects,
+                                  FixedDirections      fixed_directions,
+                                  CobiwmRectangle       *rect)
+{
+  GArray *region = region_list_to_array (spanning_rects);
+
+  cobiwm_rectangle_shove_into_region_array (region, fixed_directions, rect);
+  g_array_free (region, TRUE);
+}
+
 void
 cobiwm_rectangle_find_linepoint_closest_to_point (double x1,
                                                 double y1,
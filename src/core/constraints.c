@@ -136,12 +136,36 @@ typedef struct
   /* Spanning rectangles for the non-covered (by struts) region of the
    * screen and also for just the current monitor
    */
-  GList  *usable_screen_region;
-  GList  *usable_monitor_region;
+  GArray *usable_screen_region;
+  GArray *usable_monitor_region;
+
+  /* Size hints of the window converted to frame coordinates, and its
+   * aspect ratio limits; these don't change while constraining
+   */
+  CobiwmRectangle        min_size;
+  CobiwmRectangle        max_size;
+  double               min_aspect;
+  double               max_aspect;
 } ConstraintInfo;
 
+/* Inputs to the constraints which can only change if the monitors, the
+ * struts or the workspaces change, kept for the duration of a move or
+ * resize grab op so that they aren't recomputed on every motion event.
+ */
+struct CobiwmConstraintCache
+{
+  CobiwmWindow    *window;
+  CobiwmWorkspace *workspace;
+  gboolean       on_all_workspaces;
+  int            n_monitors;
+
+  /* Work area of the window on each monitor, filled in on demand */
+  CobiwmRectangle *work_area_monitor;
+  gboolean      *work_area_valid;
+};
+
 static gboolean do_screen_and_monitor_relative_constraints (CobiwmWindow     *window,
-                                                            GList          *region_spanning_rectangles,
+                                                            GArray         *region_spanning_rectangles,
                                                             ConstraintInfo *info,
                                                             gboolean        check_only);
 static gboolean constrain_modal_dialog       (CobiwmWindow         *window,
@@ -197,6 +221,8 @@ static void setup_constraint_info        (ConstraintInfo      *info,
                                           CobiwmRectangle       *new);
 static void place_window_if_needed       (CobiwmWindow     *window,
                                           ConstraintInfo *info);
+static void setup_size_limits            (CobiwmWindow     *window,
+                                          ConstraintInfo *info);
 static void update_onscreen_requirements (CobiwmWindow     *window,
                                           ConstraintInfo *info);
 
@@ -288,6 +314,7 @@ cobiwm_window_constrain (CobiwmWindow          *window,
                          orig,
                          new);
   place_window_if_needed (window, &info);
+  setup_size_limits (window, &info);
 
   while (!satisfied && priority <= PRIORITY_MAXIMUM) {
     gboolean check_only = TRUE;
@@ -314,6 +341,85 @@ cobiwm_window_constrain (CobiwmWindow          *window,
   update_onscreen_requirements (window, &info);
 }
 
+void
+cobiwm_display_invalidate_constraint_cache (CobiwmDisplay *display)
+{
+  CobiwmConstraintCache *cache = display->grab_constraint_cache;
+
+  if (cache == NULL)
+    return;
+
+  g_free (cache->work_area_monitor);
+  g_free (cache->work_area_valid);
+  g_free (cache);
+  display->grab_constraint_cache = NULL;
+}
+
+static CobiwmConstraintCache *
+get_constraint_cache (CobiwmWindow *window)
+{
+  CobiwmDisplay *display = window->display;
+  CobiwmConstraintCache *cache;
+
+  if (display->grab_window != window ||
+      !(cobiwm_grab_op_is_moving (display->grab_op) ||
+        cobiwm_grab_op_is_resizing (display->grab_op)))
+    return NULL;
+
+  cache = display->grab_constraint_cache;
+  if (cache != NULL &&
+      (cache->window            != window                    ||
+       cache->workspace         != window->workspace         ||
+       cache->on_all_workspaces != window->on_all_workspaces ||
+       cache->n_monitors        != window->screen->n_monitor_infos))
+    {
+      cobiwm_display_invalidate_constraint_cache (display);
+      cache = NULL;
+    }
+
+  if (cache == NULL)
+    {
+      cache = g_new0 (CobiwmConstraintCache, 1);
+      cache->window = window;
+      cache->workspace = window->workspace;
+      cache->on_all_workspaces = window->on_all_workspaces;
+      cache->n_monitors = window->screen->n_monitor_infos;
+      cache->work_area_monitor = g_new (CobiwmRectangle, cache->n_monitors);
+      cache->work_area_valid = g_new0 (gboolean, cache->n_monitors);
+      display->grab_constraint_cache = cache;
+    }
+
+  return cache;
+}
+
+/* cobiwm_window_get_work_area_for_monitor() intersects the work areas of
+ * all the workspaces the window is on, so avoid doing that for every
+ * motion event of a grab op.
+ */
+static void
+get_work_area_for_monitor (CobiwmWindow    *window,
+                           int            which_monitor,
+                           CobiwmRectangle *area)
+{
+  CobiwmConstraintCache *cache = get_constraint_cache (window);
+
+  if (cache == NULL)
+    {
+      cobiwm_window_get_work_area_for_monitor (window, which_monitor, area);
+      return;
+    }
+
+  if (!cache->work_area_valid[which_monitor])
+    {
+      cobiwm_window_get_work_area_for_monitor (window,
+                                             which_monitor,
+                                             &cache->work_area_monitor[which_monitor]);
+      cache->work_area_valid[which_monitor] = TRUE;
+    }
+
+  *area = cache->work_area_monitor[which_monitor];
+}
+
 static void
 setup_constraint_info (ConstraintInfo      *info,
                        CobiwmWindow          *window,
@@ -372,9 +478,9 @@ setup_constraint_info (ConstraintInfo      *info,
 
   monitor_info =
     cobiwm_screen_get_monitor_for_rect (window->screen, &info->current);
-  cobiwm_window_get_work_area_for_monitor (window,
-                                         monitor_info->number,
-                                         &info->work_area_monitor);
+  get_work_area_for_monitor (window,
+                             monitor_info->number,
+                             &info->work_area_monitor);
 
   if (!window->fullscreen || window->fullscreen_monitors[0] == -1)
     {
@@ -473,9 +579,9 @@ place_window_if_needed(CobiwmWindow     *window,
       monitor_info =
         cobiwm_screen_get_monitor_for_rect (window->screen, &placed_rect);
       info->entire_monitor = monitor_info->rect;
-      cobiwm_window_get_work_area_for_monitor (window,
-                                             monitor_info->number,
-                                             &info->work_area_monitor);
+      get_work_area_for_monitor (window,
+                                 monitor_info->number,
+                                 &info->work_area_monitor);
       cur_workspace = window->screen->active_workspace;
       info->usable_monitor_region =
         cobiwm_workspace_get_onmonitor_region (cur_workspace,
@@ -576,8 +682,8 @@ update_onscreen_requirements (CobiwmWindow     *window,
    */
   old = window->require_fully_onscreen;
   window->require_fully_onscreen =
-    cobiwm_rectangle_contained_in_region (info->usable_screen_region,
-                                        &info->current);
+    cobiwm_rectangle_contained_in_region_array (info->usable_screen_region,
+                                              &info->current);
   if (old != window->require_fully_onscreen)
     cobiwm_topic (COBIWM_DEBUG_GEOMETRY,
                 "require_fully_onscreen for %s toggled to %s\n",
@@ -589,8 +695,8 @@ update_onscreen_requirements (CobiwmWindow     *window,
    */
   old = window->require_on_single_monitor;
   window->require_on_single_monitor =
-    cobiwm_rectangle_contained_in_region (info->usable_monitor_region,
-                                        &info->current);
+    cobiwm_rectangle_contained_in_region_array (info->usable_monitor_region,
+                                              &info->current);
   if (old != window->require_on_single_monitor)
     cobiwm_topic (COBIWM_DEBUG_GEOMETRY,
                 "require_on_single_monitor for %s toggled to %s\n",
@@ -613,8 +719,8 @@ update_onscreen_requirements (CobiwmWindow     *window,
 
       old = window->require_titlebar_visible;
       window->require_titlebar_visible =
-        cobiwm_rectangle_overlaps_with_region (info->usable_screen_region,
-                                             &titlebar_rect);
+        cobiwm_rectangle_overlaps_with_region_array (info->usable_screen_region,
+                                                   &titlebar_rect);
       if (old != window->require_titlebar_visible)
         cobiwm_topic (COBIWM_DEBUG_GEOMETRY,
                     "require_titlebar_visible for %s toggled to %s\n",
@@ -623,11 +729,16 @@ update_onscreen_requirements (CobiwmWindow     *window,
     }
 }
 
-static inline void
-get_size_limits (CobiwmWindow    *window,
-                 CobiwmRectangle *min_size,
-                 CobiwmRectangle *max_size)
+/* Done after placement, as maximizing after placement can change the
+ * frame borders.
+ */
+static void
+setup_size_limits (CobiwmWindow     *window,
+                   ConstraintInfo *info)
 {
+  CobiwmRectangle *min_size = &info->min_size;
+  CobiwmRectangle *max_size = &info->max_size;
+
   /* We pack the results into CobiwmRectangle structs just for convienience; we
    * don't actually use the position of those rects.
    */
@@ -639,6 +750,20 @@ get_size_limits (CobiwmWindow    *window,
 
   cobiwm_window_client_rect_to_frame_rect (window, min_size, min_size);
   cobiwm_window_client_rect_to_frame_rect (window, max_size, max_size);
+
+  info->min_aspect =         window->size_hints.min_aspect.x /
+                     (double)window->size_hints.min_aspect.y;
+  info->max_aspect =         window->size_hints.max_aspect.x /
+                     (double)window->size_hints.max_aspect.y;
+}
+
+static inline void
+get_size_limits (const ConstraintInfo *info,
+                 CobiwmRectangle        *min_size,
+                 CobiwmRectangle        *max_size)
+{
+  *min_size = info->min_size;
+  *max_size = info->max_size;
 }
 
 static gboolean
@@ -742,7 +867,7 @@ constrain_maximization (CobiwmWindow         *window,
   /* Check min size constraints; max size constraints are ignored for maximized
    * windows, as per bug 327543.
    */
-  get_size_limits (window, &min_size, &max_size);
+  get_size_limits (info, &min_size, &max_size);
   hminbad = target_size.width < min_size.width && window->maximized_horizontally;
   vminbad = target_size.height < min_size.height && window->maximized_vertically;
   if (hminbad || vminbad)
@@ -800,7 +925,7 @@ constrain_tiling (CobiwmWindow         *window,
   /* Check min size constraints; max size constraints are ignored as for
    * maximized windows.
    */
-  get_size_limits (window, &min_size, &max_size);
+  get_size_limits (info, &min_size, &max_size);
   hminbad = target_size.width < min_size.width;
   vminbad = target_size.height < min_size.height;
   if (hminbad || vminbad)
@@ -843,7 +968,7 @@ constrain_fullscreen (CobiwmWindow         *window,
 
   monitor = info->entire_monitor;
 
-  get_size_limits (window, &min_size, &max_size);
+  get_size_limits (info, &min_size, &max_size);
   too_big =   !cobiwm_rectangle_could_fit_rect (&monitor, &min_size);
   too_small = !cobiwm_rectangle_could_fit_rect (&max_size, &monitor);
   if (too_big || too_small)
@@ -963,7 +1088,7 @@ constrain_size_limits (CobiwmWindow         *window,
     return TRUE;
 
   /* Determine whether constraint is already satisfied; exit if it is */
-  get_size_limits (window, &min_size, &max_size);
+  get_size_limits (info, &min_size, &max_size);
   /* We ignore max-size limits for maximized windows; see #327543 */
   if (window->maximized_horizontally)
     max_size.width = MAX (max_size.width, info->current.width);
@@ -1013,10 +1138,8 @@ constrain_aspect_ratio (CobiwmWindow         *window,
     return TRUE;
 
   /* Determine whether constraint applies; exit if it doesn't. */
-  minr =         window->size_hints.min_aspect.x /
-         (double)window->size_hints.min_aspect.y;
-  maxr =         window->size_hints.max_aspect.x /
-         (double)window->size_hints.max_aspect.y;
+  minr = info->min_aspect;
+  maxr = info->max_aspect;
   constraints_are_inconsistent = minr > maxr;
   if (constraints_are_inconsistent ||
       COBIWM_WINDOW_MAXIMIZED (window) || window->fullscreen ||
@@ -1145,7 +1268,7 @@ constrain_aspect_ratio (CobiwmWindow         *window,
 static gboolean
 do_screen_and_monitor_relative_constraints (
   CobiwmWindow     *window,
-  GList          *region_spanning_rectangles,
+  GArray         *region_spanning_rectangles,
   ConstraintInfo *info,
   gboolean        check_only)
 {
@@ -1156,18 +1279,19 @@ do_screen_and_monitor_relative_constraints (
   if (cobiwm_is_verbose ())
     {
       /* First, log some debugging information */
-      char spanning_region[1 + 28 * g_list_length (region_spanning_rectangles)];
+      char spanning_region[1 + 28 * MAX (region_spanning_rectangles->len, 1)];
 
       cobiwm_topic (COBIWM_DEBUG_GEOMETRY,
              "screen/monitor constraint; region_spanning_rectangles: %s\n",
-             cobiwm_rectangle_region_to_string (region_spanning_rectangles, ", ",
-                                              spanning_region));
+             cobiwm_rectangle_region_array_to_string (region_spanning_rectangles,
+                                                    ", ",
+                                                    spanning_region));
     }
 #endif
 
   /* Determine whether constraint applies; exit if it doesn't */
   how_far_it_can_be_smushed = info->current;
-  get_size_limits (window, &min_size, &max_size);
+  get_size_limits (info, &min_size, &max_size);
 
   if (info->action_type != ACTION_MOVE)
     {
@@ -1177,14 +1301,14 @@ do_screen_and_monitor_relative_constraints (
       if (!(info->fixed_directions & FIXED_DIRECTION_Y))
         how_far_it_can_be_smushed.height = min_size.height;
     }
-  if (!cobiwm_rectangle_could_fit_in_region (region_spanning_rectangles,
-                                           &how_far_it_can_be_smushed))
+  if (!cobiwm_rectangle_could_fit_in_region_array (region_spanning_rectangles,
+                                                 &how_far_it_can_be_smushed))
     exit_early = TRUE;
 
   /* Determine whether constraint is already satisfied; exit if it is */
   constraint_satisfied =
-    cobiwm_rectangle_contained_in_region (region_spanning_rectangles,
-                                        &info->current);
+    cobiwm_rectangle_contained_in_region_array (region_spanning_rectangles,
+                                              &info->current);
   if (exit_early || constraint_satisfied || check_only)
     return constraint_satisfied;
 
@@ -1192,21 +1316,21 @@ do_screen_and_monitor_relative_constraints (
 
   /* Clamp rectangle size for resize or move+resize actions */
   if (info->action_type != ACTION_MOVE)
-    cobiwm_rectangle_clamp_to_fit_into_region (region_spanning_rectangles,
-                                             info->fixed_directions,
-                                             &info->current,
-                                             &min_size);
+    cobiwm_rectangle_clamp_to_fit_into_region_array (region_spanning_rectangles,
+                                                   info->fixed_directions,
+                                                   &info->current,
+                                                   &min_size);
 
   if (info->is_user_action && info->action_type == ACTION_RESIZE)
     /* For user resize, clip to the relevant region */
-    cobiwm_rectangle_clip_to_region (region_spanning_rectangles,
-                                   info->fixed_directions,
-                                   &info->current);
+    cobiwm_rectangle_clip_to_region_array (region_spanning_rectangles,
+                                         info->fixed_directions,
+                                         &info->current);
   else
     /* For everything else, shove the rectangle into the relevant region */
-    cobiwm_rectangle_shove_into_region (region_spanning_rectangles,
-                                      info->fixed_directions,
-                                      &info->current);
+    cobiwm_rectangle_shove_into_region_array (region_spanning_rectangles,
+                                            info->fixed_directions,
+                                            &info->current);
 
   return TRUE;
 }
@@ -1331,25 +1455,25 @@ constrain_titlebar_visible (CobiwmWindow         *window,
   /* Extend the region, have a helper function handle the constraint,
    * then return the region to its original size.
    */
-  cobiwm_rectangle_expand_region_conditionally (info->usable_screen_region,
-                                              horiz_amount_offscreen,
-                                              horiz_amount_offscreen,
-                                              0, /* Don't let titlebar off */
-                                              bottom_amount,
-                                              horiz_amount_onscreen,
-                                              vert_amount_onscreen);
+  cobiwm_rectangle_expand_region_array_conditionally (info->usable_screen_region,
+                                                    horiz_amount_offscreen,
+                                                    horiz_amount_offscreen,
+                                                    0, /* Don't let titlebar off */
+                                                    bottom_amount,
+                                                    horiz_amount_onscreen,
+                                                    vert_amount_onscreen);
   retval =
     do_screen_and_monitor_relative_constraints (window,
                                                 info->usable_screen_region,
                                                 info,
                                                 check_only);
-  cobiwm_rectangle_expand_region_conditionally (info->usable_screen_region,
-                                              -horiz_amount_offscreen,
-                                              -horiz_amount_offscreen,
-                                              0, /* Don't let titlebar off */
-                                              -bottom_amount,
-                                              horiz_amount_onscreen,
-                                              vert_amount_onscreen);
+  cobiwm_rectangle_expand_region_array_conditionally (info->usable_screen_region,
+                                                    -horiz_amount_offscreen,
+                                                    -horiz_amount_offscreen,
+                                                    0, /* Don't let titlebar off */
+                                                    -bottom_amount,
+                                                    horiz_amount_onscreen,
+                                                    vert_amount_onscreen);
 
   return retval;
 }
@@ -1409,25 +1533,25 @@ constrain_partially_onscreen (CobiwmWindow         *window,
   /* Extend the region, have a helper function handle the constraint,
    * then return the region to its original size.
    */
-  cobiwm_rectangle_expand_region_conditionally (info->usable_screen_region,
-                                              horiz_amount_offscreen,
-                                              horiz_amount_offscreen,
-                                              top_amount,
-                                              bottom_amount,
-                                              horiz_amount_onscreen,
-                                              vert_amount_onscreen);
+  cobiwm_rectangle_expand_region_array_conditionally (info->usable_screen_region,
+                                                    horiz_amount_offscreen,
+                                                    horiz_amount_offscreen,
+                                                    top_amount,
+                                                    bottom_amount,
+                                                    horiz_amount_onscreen,
+                                                    vert_amount_onscreen);
   retval =
     do_screen_and_monitor_relative_constraints (window,
                                                 info->usable_screen_region,
                                                 info,
                                                 check_only);
-  cobiwm_rectangle_expand_region_conditionally (info->usable_screen_region,
-                                              -horiz_amount_offscreen,
-                                              -horiz_amount_offscreen,
-                                              -top_amount,
-                                              -bottom_amount,
-                                              horiz_amount_onscreen,
-                                              vert_amount_onscreen);
+  cobiwm_rectangle_expand_region_array_conditionally (info->usable_screen_region,
+                                                    -horiz_amount_offscreen,
+                                                    -horiz_amount_offscreen,
+                                                    -top_amount,
+                                                    -bottom_amount,
+                                                    horiz_amount_onscreen,
+                                                    vert_amount_onscreen);
 
   return retval;
 }
@@ -262,10 +262,36 @@ cobiwm_core_grab_buttons  (Display *xdisplay,
 
   display = cobiwm_display_for_x_display (xdisplay);
 
+  /* With lazy grabs, entering the window grabs the buttons */
+  if (display->key_binding_manager.lazy_window_grabs)
+    return;
+
   cobiwm_verbose ("Grabbing buttons on frame 0x%lx\n", frame_xwindow);
   cobiwm_display_grab_window_buttons (display, frame_xwindow);
 }
 
+/* Drops every passive key and button grab on a frame window, whoever
+ * made it, so the window can be pooled and handed to another frame.
+ */
+void
+cobiwm_core_ungrab_all (Display *xdisplay,
+                      Window   frame_xwindow)
+{
+  CobiwmDisplay *display;
+  XIGrabModifiers mods = { XIAnyModifier, 0 };
+
+  display = cobiwm_display_for_x_display (xdisplay);
+
+  cobiwm_verbose ("Ungrabbing keys and buttons on frame 0x%lx\n", frame_xwindow);
+
+  cobiwm_error_trap_push (display);
+  XIUngrabKeycode (xdisplay, COBIWM_VIRTUAL_CORE_KEYBOARD_ID,
+                   XIAnyKeycode, frame_xwindow, 1, &mods);
+  XIUngrabButton (xdisplay, COBIWM_VIRTUAL_CORE_POINTER_ID,
+                  XIAnyButton, frame_xwindow, 1, &mods);
+  cobiwm_error_trap_pop (display);
+}
+
 void
 cobiwm_core_set_screen_cursor (Display *xdisplay,
                              Window   frame_on_screen,
@@ -72,6 +72,8 @@ CobiwmGrabOp cobiwm_core_get_grab_op     (Display    *xdisplay);
 
 void       cobiwm_core_grab_buttons  (Display *xdisplay,
                                     Window   frame_xwindow);
+void       cobiwm_core_ungrab_all    (Display *xdisplay,
+                                    Window   frame_xwindow);
 
 void       cobiwm_core_set_screen_cursor (Display *xdisplay,
                                         Window   frame_on_screen,
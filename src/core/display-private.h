@@ -37,6 +37,7 @@
 #include "keybindings-private.h"
 #include "startup-notification-private.h"
 #include "cobiwm-gesture-tracker-private.h"
+#include "x11/event-trace.h"
 #include <prefs.h>
 #include <barrier.h>
 #include <clutter/clutter.h>
@@ -54,6 +55,8 @@ typedef struct _CobiwmGroupPropHooks  CobiwmGroupPropHooks;
 typedef struct _CobiwmWindowPropHooks CobiwmWindowPropHooks;
 
 typedef struct CobiwmEdgeResistanceData CobiwmEdgeResistanceData;
+typedef struct CobiwmConstraintCache CobiwmConstraintCache;
+typedef struct CobiwmInitialProperties CobiwmInitialProperties;
 
 typedef enum {
   COBIWM_LIST_DEFAULT                   = 0,      /* normal windows */
@@ -182,6 +185,12 @@ struct _CobiwmDisplay
 
   guint32 current_time;
 
+  /* The latest server time we saw in an event, and when we saw it;
+   * see cobiwm_display_note_server_time()
+   */
+  guint32 server_time_sample;
+  gint64 server_time_sample_monotonic;
+
   /* We maintain a sequence counter, incremented for each #CobiwmWindow
    * created.  This is exposed by cobiwm_window_get_stable_sequence()
    * but is otherwise not used inside cobiwm.
@@ -215,6 +224,13 @@ struct _CobiwmDisplay
   int           grab_tile_monitor_number;
   int         grab_latest_motion_x;
   int         grab_latest_motion_y;
+  /* Pointer motion of a mouse grab op not yet applied; it is coalesced
+   * and applied once per frame, see window.c:queue_grab_motion()
+   */
+  guint       grab_motion_later_id;
+  int         grab_pending_motion_x;
+  int         grab_pending_motion_y;
+  gboolean    grab_pending_motion_snap;
   guint       grab_have_pointer : 1;
   guint       grab_have_keyboard : 1;
   guint       grab_frame_action : 1;
@@ -223,6 +239,7 @@ struct _CobiwmDisplay
   gboolean    grab_threshold_movement_reached; /* raise_on_click == FALSE.    */
   GTimeVal    grab_last_moveresize_time;
   CobiwmEdgeResistanceData *grab_edge_resistance_data;
+  CobiwmConstraintCache *grab_constraint_cache;
   unsigned int grab_last_user_action_was_snap;
 
   /* we use property updates as sentinels for certain window focus events
@@ -252,6 +269,14 @@ struct _CobiwmDisplay
   CobiwmWindowPropHooks *prop_hooks_table;
   GHashTable *prop_hooks;
   int n_prop_hooks;
+  CobiwmInitialProperties *prefetched_initial_properties;
+  GArray *pending_property_reloads;
+  guint property_reload_idle_id;
+
+  /* Managed by events.c */
+  CobiwmEventTrace *event_trace;
+  /* CobiwmEventDispatch flags, by event type */
+  guint8 event_dispatch[128];
 
   /* Managed by group-props.c */
   CobiwmGroupPropHooks *group_prop_hooks;
@@ -400,13 +425,22 @@ void     cobiwm_display_grab_window_buttons    (CobiwmDisplay *display,
 void     cobiwm_display_ungrab_window_buttons  (CobiwmDisplay *display,
                                               Window       xwindow);
 
+void     cobiwm_display_update_lazy_button_grabs (CobiwmDisplay *display,
+                                                CobiwmWindow  *window);
+void     cobiwm_display_forget_lazy_grab_window  (CobiwmDisplay *display,
+                                                CobiwmWindow  *window);
+
 void cobiwm_display_grab_focus_window_button   (CobiwmDisplay *display,
                                               CobiwmWindow  *window);
 void cobiwm_display_ungrab_focus_window_button (CobiwmDisplay *display,
                                               CobiwmWindow  *window);
 
-/* Next function is defined in edge-resistance.c */
+/* Next functions are defined in edge-resistance.c */
 void cobiwm_display_cleanup_edges              (CobiwmDisplay *display);
+void cobiwm_display_release_edges              (CobiwmDisplay *display);
+
+/* Next function is defined in constraints.c */
+void cobiwm_display_invalidate_constraint_cache (CobiwmDisplay *display);
 
 /* make a request to ensure the event serial has changed */
 void     cobiwm_display_increment_event_serial (CobiwmDisplay *display);
@@ -463,6 +497,9 @@ void cobiwm_display_update_focus_window (CobiwmDisplay *display,
                                        gulong       serial,
                                        gboolean     focused_by_us);
 
+void cobiwm_display_note_server_time (CobiwmDisplay *display,
+                                    guint32      server_time);
+
 void cobiwm_display_sanity_check_timestamps (CobiwmDisplay *display,
                                            guint32      timestamp);
 gboolean cobiwm_display_timestamp_too_old (CobiwmDisplay *display,
@@ -643,6 +643,7 @@ cobiwm_display_open (void)
   display->sentinel_counter = 0;
 
   display->grab_resize_timeout_id = 0;
+  display->grab_motion_later_id = 0;
   display->grab_have_keyboard = FALSE;
 
   display->last_bell_time = 0;
@@ -653,6 +654,7 @@ cobiwm_display_open (void)
   display->grab_tile_monitor_number = -1;
 
   display->grab_edge_resistance_data = NULL;
+  display->grab_constraint_cache = NULL;
 
   {
     int major, minor;
@@ -815,6 +817,8 @@ cobiwm_display_open (void)
       cobiwm_fatal ("X server doesn't have the XInput extension, version 2.2 or newer\n");
   }
 
+  cobiwm_display_init_event_dispatch_x11 (display);
+
   update_cursor_theme ();
 
   /* Create the leader window here. Set its properties and
@@ -1102,6 +1106,10 @@ cobiwm_display_close (CobiwmDisplay *display,
 
   cobiwm_screen_free (display->screen, timestamp);
 
+  cobiwm_display_cleanup_edges (display);
+  cobiwm_display_invalidate_constraint_cache (display);
+  cobiwm_window_discard_prefetched_properties (display);
+
   /* Must be after all calls to cobiwm_window_unmanage() since they
    * unregister windows
    */
@@ -1284,6 +1292,60 @@ find_timestamp_predicate (Display  *xdisplay,
           ev->xproperty.atom == display->atom__COBIWM_TIMESTAMP_PING);
 }
 
+/* How long after an event we extrapolate the server time from it */
+#define SERVER_TIME_SAMPLE_MAX_AGE (1000 * 1000)
+
+/**
+ * cobiwm_display_note_server_time:
+ * @display: a #CobiwmDisplay
+ * @server_time: a timestamp the X server put in an event
+ *
+ * Remembers @server_time along with when we got it, so that
+ * cobiwm_display_get_current_time_roundtrip() can work out the current
+ * server time for a while without asking the server.  Only timestamps
+ * generated by the server itself may be passed here, not ones which
+ * came from clients.
+ */
+void
+cobiwm_display_note_server_time (CobiwmDisplay *display,
+                               guint32      server_time)
+{
+  if (server_time == CurrentTime ||
+      (display->server_time_sample_monotonic != 0 &&
+       XSERVER_TIME_IS_BEFORE (server_time, display->server_time_sample)))
+    return;
+
+  display->server_time_sample = server_time;
+  display->server_time_sample_monotonic = g_get_monotonic_time ();
+}
+
+/* The server time now, worked out from the last one noted; CurrentTime
+ * if that is too old to be sure of.
+ */
+static guint32
+estimate_server_time (CobiwmDisplay *display)
+{
+  gint64 elapsed;
+  guint32 timestamp;
+
+  if (display->server_time_sample_monotonic == 0)
+    return CurrentTime;
+
+  elapsed = g_get_monotonic_time () - display->server_time_sample_monotonic;
+  if (elapsed > SERVER_TIME_SAMPLE_MAX_AGE)
+    return CurrentTime;
+
+  /* The server can ignore requests with timestamps in its future, such
+   * as a SetInputFocus, so err on the early side.  The event was
+   * generated before we got it, which makes up for rounding down to
+   * milliseconds; the extra millisecond makes up for the two clocks
+   * not running at quite the same rate.
+   */
+  timestamp = display->server_time_sample + MAX (elapsed / 1000 - 1, 0);
+
+  return timestamp;
+}
+
 /* Get a timestamp, even if it means a roundtrip */
 guint32
 cobiwm_display_get_current_time_roundtrip (CobiwmDisplay *display)
@@ -1291,6 +1353,8 @@ cobiwm_display_get_current_time_roundtrip (CobiwmDisplay *display)
   guint32 timestamp;
 
   timestamp = cobiwm_display_get_current_time (display);
+  if (timestamp == CurrentTime)
+    timestamp = estimate_server_time (display);
   if (timestamp == CurrentTime)
     {
       XEvent property_event;
@@ -1303,6 +1367,8 @@ cobiwm_display_get_current_time_roundtrip (CobiwmDisplay *display)
                 find_timestamp_predicate,
                 (XPointer) display);
       timestamp = property_event.xproperty.time;
+
+      cobiwm_display_note_server_time (display, timestamp);
     }
 
   cobiwm_display_sanity_check_timestamps (display, timestamp);
@@ -1961,8 +2027,9 @@ cobiwm_display_end_grab_op (CobiwmDisplay *display,
 
   if (display->event_route == COBIWM_EVENT_ROUTE_WINDOW_OP)
     {
-      /* Clear out the edge cache */
-      cobiwm_display_cleanup_edges (display);
+      /* Stop using the edge cache; it is kept for the next grab */
+      cobiwm_display_release_edges (display);
+      cobiwm_display_invalidate_constraint_cache (display);
 
       /* Only raise the window in orthogonal raise
        * ('do-not-raise-on-click') mode if the user didn't try to move
@@ -2003,6 +2070,13 @@ cobiwm_display_end_grab_op (CobiwmDisplay *display,
       display->grab_resize_timeout_id = 0;
     }
 
+  /* Any motion not applied yet is dropped along with the grab */
+  if (display->grab_motion_later_id)
+    {
+      cobiwm_later_remove (display->grab_motion_later_id);
+      display->grab_motion_later_id = 0;
+    }
+
   if (cobiwm_is_wayland_compositor ())
     cobiwm_display_sync_wayland_input_focus (display);
 }
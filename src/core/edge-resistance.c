@@ -20,6 +20,7 @@
  */
 
 #include <config.h>
+#include <string.h>
 #include "edge-resistance.h"
 #include "boxes-private.h"
 #include "display-private.h"
@@ -47,12 +48,39 @@ struct ResistanceDataForAnEdge
 };
 typedef struct ResistanceDataForAnEdge ResistanceDataForAnEdge;
 
+/* A window whose edges went into the edge index, recorded so that a later
+ * grab can tell whether the index is still accurate without recomputing it.
+ */
+struct IndexedWindow
+{
+  guint64         stamp;
+  CobiwmRectangle rect;
+  gboolean        is_dock;
+};
+typedef struct IndexedWindow IndexedWindow;
+
+/* The edge index is kept around after a grab ends and is reused by the next
+ * grab as long as the set, stacking and geometry of relevant windows is
+ * unchanged.  Work area changes and workspace switches drop it entirely
+ * through cobiwm_display_cleanup_edges().
+ */
 struct CobiwmEdgeResistanceData
 {
-  GArray *left_edges;
-  GArray *right_edges;
-  GArray *top_edges;
-  GArray *bottom_edges;
+  /* Storage for the (possibly split) window edges; the arrays below point
+   * into it.  Monitor and screen edges are owned by the workspace.
+   */
+  GArray *window_edges;
+
+  /* Left and right edges sorted by x, top and bottom edges sorted by y */
+  GArray *left_right_edges;
+  GArray *top_bottom_edges;
+
+  /* What the index was computed from */
+  CobiwmWorkspace *workspace;
+  GArray        *windows;
+
+  /* Whether the index has been checked against the current grab */
+  gboolean       validated;
 
   ResistanceDataForAnEdge left_data;
   ResistanceDataForAnEdge right_data;
@@ -551,7 +579,8 @@ apply_edge_resistance_to_each_side (CobiwmDisplay         *display,
   gboolean                modified;
   int new_left, new_right, new_top, new_bottom;
 
-  if (display->grab_edge_resistance_data == NULL)
+  if (display->grab_edge_resistance_data == NULL ||
+      !display->grab_edge_resistance_data->validated)
     compute_resistance_and_snapping_edges (display);
 
   edge_data = display->grab_edge_resistance_data;
@@ -566,28 +595,28 @@ apply_edge_resistance_to_each_side (CobiwmDisplay         *display,
       new_left   = apply_edge_snapping (BOX_LEFT (*old_outer),
                                         BOX_LEFT (*new_outer),
                                         new_outer,
-                                        edge_data->left_edges,
+                                        edge_data->left_right_edges,
                                         TRUE,
                                         keyboard_op);
 
       new_right  = apply_edge_snapping (BOX_RIGHT (*old_outer),
                                         BOX_RIGHT (*new_outer),
                                         new_outer,
-                                        edge_data->right_edges,
+                                        edge_data->left_right_edges,
                                         TRUE,
                                         keyboard_op);
 
       new_top    = apply_edge_snapping (BOX_TOP (*old_outer),
                                         BOX_TOP (*new_outer),
                                         new_outer,
-                                        edge_data->top_edges,
+                                        edge_data->top_bottom_edges,
                                         FALSE,
                                         keyboard_op);
 
       new_bottom = apply_edge_snapping (BOX_BOTTOM (*old_outer),
                                         BOX_BOTTOM (*new_outer),
                                         new_outer,
-                                        edge_data->bottom_edges,
+                                        edge_data->top_bottom_edges,
                                         FALSE,
                                         keyboard_op);
     }
@@ -605,7 +634,7 @@ apply_edge_resistance_to_each_side (CobiwmDisplay         *display,
                                               BOX_LEFT (*new_outer),
                                               old_outer,
                                               new_outer,
-                                              edge_data->left_edges,
+                                              edge_data->left_right_edges,
                                               &edge_data->left_data,
                                               timeout_func,
                                               TRUE,
@@ -615,7 +644,7 @@ apply_edge_resistance_to_each_side (CobiwmDisplay         *display,
                                               BOX_RIGHT (*new_outer),
                                               old_outer,
                                               new_outer,
-                                              edge_data->right_edges,
+                                              edge_data->left_right_edges,
                                               &edge_data->right_data,
                                               timeout_func,
                                               TRUE,
@@ -634,7 +663,7 @@ apply_edge_resistance_to_each_side (CobiwmDisplay         *display,
                                               BOX_TOP (*new_outer),
                                               old_outer,
                                               new_outer,
-                                              edge_data->top_edges,
+                                              edge_data->top_bottom_edges,
                                               &edge_data->top_data,
                                               timeout_func,
                                               FALSE,
@@ -644,7 +673,7 @@ apply_edge_resistance_to_each_side (CobiwmDisplay         *display,
                                               BOX_BOTTOM (*new_outer),
                                               old_outer,
                                               new_outer,
-                                              edge_data->bottom_edges,
+                                              edge_data->top_bottom_edges,
                                               &edge_data->bottom_data,
                                               timeout_func,
                                               FALSE,
@@ -667,75 +696,9 @@ apply_edge_resistance_to_each_side (CobiwmDisplay         *display,
   return modified;
 }
 
-void
-cobiwm_display_cleanup_edges (CobiwmDisplay *display)
+static void
+cleanup_resistance_timeouts (CobiwmEdgeResistanceData *edge_data)
 {
-  guint i,j;
-  CobiwmEdgeResistanceData *edge_data = display->grab_edge_resistance_data;
-  GHashTable *edges_to_be_freed;
-
-  if (edge_data == NULL) /* Not currently cached */
-    return;
-
-  /* We first need to clean out any window edges */
-  edges_to_be_freed = g_hash_table_new_full (g_direct_hash, g_direct_equal,
-                                             g_free, NULL);
-  for (i = 0; i < 4; i++)
-    {
-      GArray *tmp = NULL;
-      CobiwmSide side;
-      switch (i)
-        {
-        case 0:
-          tmp = edge_data->left_edges;
-          side = COBIWM_SIDE_LEFT;
-          break;
-        case 1:
-          tmp = edge_data->right_edges;
-          side = COBIWM_SIDE_RIGHT;
-          break;
-        case 2:
-          tmp = edge_data->top_edges;
-          side = COBIWM_SIDE_TOP;
-          break;
-        case 3:
-          tmp = edge_data->bottom_edges;
-          side = COBIWM_SIDE_BOTTOM;
-          break;
-        default:
-          g_assert_not_reached ();
-        }
-
-      for (j = 0; j < tmp->len; j++)
-        {
-          CobiwmEdge *edge = g_array_index (tmp, CobiwmEdge*, j);
-          if (edge->edge_type == COBIWM_EDGE_WINDOW &&
-              edge->side_type == side)
-            {
-              /* The same edge will appear in two arrays, and we can't free
-               * it yet we still need to compare edge->side_type for the other
-               * array that it is in.  So store it in a hash table for later
-               * freeing.  Could also do this in a simple linked list.
-               */
-              g_hash_table_insert (edges_to_be_freed, edge, edge);
-            }
-        }
-    }
-
-  /* Now free all the window edges (the key destroy function is g_free) */
-  g_hash_table_destroy (edges_to_be_freed);
-
-  /* Now free the arrays and data */
-  g_array_free (edge_data->left_edges, TRUE);
-  g_array_free (edge_data->right_edges, TRUE);
-  g_array_free (edge_data->top_edges, TRUE);
-  g_array_free (edge_data->bottom_edges, TRUE);
-  edge_data->left_edges = NULL;
-  edge_data->right_edges = NULL;
-  edge_data->top_edges = NULL;
-  edge_data->bottom_edges = NULL;
-
-  /* Cleanup the timeouts */
   if (edge_data->left_data.timeout_setup   &&
       edge_data->left_data.timeout_id   != 0)
     g_source_remove (edge_data->left_data.timeout_id);
@@ -749,10 +712,47 @@ cobiwm_display_cleanup_edges (CobiwmDisplay *display)
       edge_data->bottom_data.timeout_id != 0)
     g_source_remove (edge_data->bottom_data.timeout_id);
 
+  memset (&edge_data->left_data,   0, sizeof (ResistanceDataForAnEdge));
+  memset (&edge_data->right_data,  0, sizeof (ResistanceDataForAnEdge));
+  memset (&edge_data->top_data,    0, sizeof (ResistanceDataForAnEdge));
+  memset (&edge_data->bottom_data, 0, sizeof (ResistanceDataForAnEdge));
+}
+
+void
+cobiwm_display_cleanup_edges (CobiwmDisplay *display)
+{
+  CobiwmEdgeResistanceData *edge_data = display->grab_edge_resistance_data;
+
+  if (edge_data == NULL) /* Not currently cached */
+    return;
+
+  cleanup_resistance_timeouts (edge_data);
+
+  /* Window edges are stored by value, everything else is borrowed */
+  g_array_free (edge_data->left_right_edges, TRUE);
+  g_array_free (edge_data->top_bottom_edges, TRUE);
+  g_array_free (edge_data->window_edges, TRUE);
+  g_array_free (edge_data->windows, TRUE);
+
   g_free (display->grab_edge_resistance_data);
   display->grab_edge_resistance_data = NULL;
 }
 
+void
+cobiwm_display_release_edges (CobiwmDisplay *display)
+{
+  CobiwmEdgeResistanceData *edge_data = display->grab_edge_resistance_data;
+
+  if (edge_data == NULL)
+    return;
+
+  /* Keep the index itself around; the next grab checks whether it is
+   * still accurate before using it.
+   */
+  cleanup_resistance_timeouts (edge_data);
+  edge_data->validated = FALSE;
+}
+
 static int
 stupid_sort_requiring_extra_pointer_dereference (gconstpointer a,
                                                  gconstpointer b)
@@ -762,376 +762,284 @@ stupid_sort_requiring_extra_pointer_dereference (gconstpointer a,
   return cobiwm_rectangle_edge_cmp_ignore_type (*a_edge, *b_edge);
 }
 
-static void
-cache_edges (CobiwmDisplay *display,
-             GList *window_edges,
-             GList *monitor_edges,
-             GList *screen_edges)
+static gboolean
+rectangles_touch (const CobiwmRectangle *a,
+                  const CobiwmRectangle *b)
 {
-  CobiwmEdgeResistanceData *edge_data;
-  GList *tmp;
-  int num_left, num_right, num_top, num_bottom;
-  int i;
-
-  /*
-   * 0th: Print debugging information to the log about the edges
+  /* Like cobiwm_rectangle_overlap(), but also true for rectangles that
+   * merely share a side, since those can still split an edge.
    */
-#ifdef WITH_VERBOSE_MODE
-  if (cobiwm_is_verbose())
-    {
-      int max_edges = MAX (MAX( g_list_length (window_edges),
-                                g_list_length (monitor_edges)),
-                           g_list_length (screen_edges));
-      char big_buffer[(EDGE_LENGTH+2)*max_edges];
-
-      cobiwm_rectangle_edge_list_to_string (window_edges, ", ", big_buffer);
-      cobiwm_topic (COBIWM_DEBUG_EDGE_RESISTANCE,
-                  "Window edges for resistance  : %s\n", big_buffer);
+  return BOX_LEFT (*a) <= BOX_RIGHT (*b)  && BOX_LEFT (*b) <= BOX_RIGHT (*a) &&
+         BOX_TOP (*a)  <= BOX_BOTTOM (*b) && BOX_TOP (*b)  <= BOX_BOTTOM (*a);
+}
 
-      cobiwm_rectangle_edge_list_to_string (monitor_edges, ", ", big_buffer);
-      cobiwm_topic (COBIWM_DEBUG_EDGE_RESISTANCE,
-                  "Monitor edges for resistance: %s\n", big_buffer);
+/* Returns the windows whose edges are relevant for the current grab, from
+ * bottom to top, together with their positions.
+ */
+static GArray *
+get_indexed_windows (CobiwmDisplay *display)
+{
+  GList *stacked_windows;
+  GList *cur_window_iter;
+  GArray *windows;
 
-      cobiwm_rectangle_edge_list_to_string (screen_edges, ", ", big_buffer);
-      cobiwm_topic (COBIWM_DEBUG_EDGE_RESISTANCE,
-                  "Screen edges for resistance  : %s\n", big_buffer);
-    }
-#endif
+  stacked_windows =
+    cobiwm_stack_list_windows (display->screen->stack,
+                             display->screen->active_workspace);
 
-  /*
-   * 1st: Get the total number of each kind of edge
-   */
-  num_left = num_right = num_top = num_bottom = 0;
-  for (i = 0; i < 3; i++)
+  windows = g_array_new (FALSE, FALSE, sizeof (IndexedWindow));
+  for (cur_window_iter = stacked_windows;
+       cur_window_iter != NULL;
+       cur_window_iter = cur_window_iter->next)
     {
-      tmp = NULL;
-      switch (i)
-        {
-        case 0:
-          tmp = window_edges;
-          break;
-        case 1:
-          tmp = monitor_edges;
-          break;
-        case 2:
-          tmp = screen_edges;
-          break;
-        default:
-          g_assert_not_reached ();
-        }
+      CobiwmWindow *cur_window = cur_window_iter->data;
 
-      while (tmp)
+      if (WINDOW_EDGES_RELEVANT (cur_window, display))
         {
-          CobiwmEdge *edge = tmp->data;
-          switch (edge->side_type)
-            {
-            case COBIWM_SIDE_LEFT:
-              num_left++;
-              break;
-            case COBIWM_SIDE_RIGHT:
-              num_right++;
-              break;
-            case COBIWM_SIDE_TOP:
-              num_top++;
-              break;
-            case COBIWM_SIDE_BOTTOM:
-              num_bottom++;
-              break;
-            default:
-              g_assert_not_reached ();
-            }
-          tmp = tmp->next;
+          IndexedWindow indexed;
+
+          indexed.stamp = cur_window->stamp;
+          indexed.is_dock = cur_window->type == COBIWM_WINDOW_DOCK;
+          cobiwm_window_get_frame_rect (cur_window, &indexed.rect);
+          g_array_append_val (windows, indexed);
         }
     }
 
-  /*
-   * 2nd: Allocate the edges
-   */
-  g_assert (display->grab_edge_resistance_data == NULL);
-  display->grab_edge_resistance_data = g_new0 (CobiwmEdgeResistanceData, 1);
-  edge_data = display->grab_edge_resistance_data;
-  edge_data->left_edges   = g_array_sized_new (FALSE,
-                                               FALSE,
-                                               sizeof(CobiwmEdge*),
-                                               num_left + num_right);
-  edge_data->right_edges  = g_array_sized_new (FALSE,
-                                               FALSE,
-                                               sizeof(CobiwmEdge*),
-                                               num_left + num_right);
-  edge_data->top_edges    = g_array_sized_new (FALSE,
-                                               FALSE,
-                                               sizeof(CobiwmEdge*),
-                                               num_top + num_bottom);
-  edge_data->bottom_edges = g_array_sized_new (FALSE,
-                                               FALSE,
-                                               sizeof(CobiwmEdge*),
-                                               num_top + num_bottom);
+  g_list_free (stacked_windows);
 
-  /*
-   * 3rd: Add the edges to the arrays
-   */
-  for (i = 0; i < 3; i++)
+  return windows;
+}
+
+static gboolean
+edge_index_is_current (CobiwmEdgeResistanceData *edge_data,
+                       CobiwmWorkspace          *workspace,
+                       GArray                 *windows)
+{
+  guint i;
+
+  if (edge_data->workspace != workspace ||
+      edge_data->windows->len != windows->len)
+    return FALSE;
+
+  for (i = 0; i < windows->len; i++)
     {
-      tmp = NULL;
-      switch (i)
-        {
-        case 0:
-          tmp = window_edges;
-          break;
-        case 1:
-          tmp = monitor_edges;
-          break;
-        case 2:
-          tmp = screen_edges;
-          break;
-        default:
-          g_assert_not_reached ();
-        }
+      IndexedWindow *old = &g_array_index (edge_data->windows, IndexedWindow, i);
+      IndexedWindow *new = &g_array_index (windows, IndexedWindow, i);
 
-      while (tmp)
-        {
-          CobiwmEdge *edge = tmp->data;
-          switch (edge->side_type)
-            {
-            case COBIWM_SIDE_LEFT:
-            case COBIWM_SIDE_RIGHT:
-              g_array_append_val (edge_data->left_edges, edge);
-              g_array_append_val (edge_data->right_edges, edge);
-              break;
-            case COBIWM_SIDE_TOP:
-            case COBIWM_SIDE_BOTTOM:
-              g_array_append_val (edge_data->top_edges, edge);
-              g_array_append_val (edge_data->bottom_edges, edge);
-              break;
-            default:
-              g_assert_not_reached ();
-            }
-          tmp = tmp->next;
-        }
+      if (old->stamp != new->stamp ||
+          old->is_dock != new->is_dock ||
+          !cobiwm_rectangle_equal (&old->rect, &new->rect))
+        return FALSE;
     }
 
-  /*
-   * 4th: Sort the arrays (FIXME: This is kinda dumb since the arrays were
-   * individually sorted earlier and we could have done this faster and
-   * avoided this sort by sticking them into the array with some simple
-   * merging of the lists).
-   */
-  g_array_sort (display->grab_edge_resistance_data->left_edges,
-                stupid_sort_requiring_extra_pointer_dereference);
-  g_array_sort (display->grab_edge_resistance_data->right_edges,
-                stupid_sort_requiring_extra_pointer_dereference);
-  g_array_sort (display->grab_edge_resistance_data->top_edges,
-                stupid_sort_requiring_extra_pointer_dereference);
-  g_array_sort (display->grab_edge_resistance_data->bottom_edges,
-                stupid_sort_requiring_extra_pointer_dereference);
+  return TRUE;
 }
 
 static void
-initialize_grab_edge_resistance_data (CobiwmDisplay *display)
+add_edge_to_index (CobiwmEdgeResistanceData *edge_data,
+                   CobiwmEdge               *edge)
 {
-  CobiwmEdgeResistanceData *edge_data = display->grab_edge_resistance_data;
+  switch (edge->side_type)
+    {
+    case COBIWM_SIDE_LEFT:
+    case COBIWM_SIDE_RIGHT:
+      g_array_append_val (edge_data->left_right_edges, edge);
+      break;
+    case COBIWM_SIDE_TOP:
+    case COBIWM_SIDE_BOTTOM:
+      g_array_append_val (edge_data->top_bottom_edges, edge);
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+}
 
-  edge_data->left_data.timeout_setup   = FALSE;
-  edge_data->right_data.timeout_setup  = FALSE;
-  edge_data->top_data.timeout_setup    = FALSE;
-  edge_data->bottom_data.timeout_setup = FALSE;
+static void
+cache_edges (CobiwmEdgeResistanceData *edge_data,
+             GList                  *monitor_edges,
+             GList                  *screen_edges)
+{
+  GList *tmp;
+  guint i;
 
-  edge_data->left_data.keyboard_buildup   = 0;
-  edge_data->right_data.keyboard_buildup  = 0;
-  edge_data->top_data.keyboard_buildup    = 0;
-  edge_data->bottom_data.keyboard_buildup = 0;
+  cobiwm_topic (COBIWM_DEBUG_EDGE_RESISTANCE,
+              "Indexing %u window, %u monitor and %u screen edges\n",
+              edge_data->window_edges->len,
+              g_list_length (monitor_edges),
+              g_list_length (screen_edges));
+
+  edge_data->left_right_edges = g_array_new (FALSE, FALSE, sizeof (CobiwmEdge*));
+  edge_data->top_bottom_edges = g_array_new (FALSE, FALSE, sizeof (CobiwmEdge*));
+
+  /* window_edges is not touched anymore from here on, so it is safe to
+   * point into it.
+   */
+  for (i = 0; i < edge_data->window_edges->len; i++)
+    add_edge_to_index (edge_data,
+                       &g_array_index (edge_data->window_edges, CobiwmEdge, i));
+  for (tmp = monitor_edges; tmp != NULL; tmp = tmp->next)
+    add_edge_to_index (edge_data, tmp->data);
+  for (tmp = screen_edges; tmp != NULL; tmp = tmp->next)
+    add_edge_to_index (edge_data, tmp->data);
+
+  g_array_sort (edge_data->left_right_edges,
+                stupid_sort_requiring_extra_pointer_dereference);
+  g_array_sort (edge_data->top_bottom_edges,
+                stupid_sort_requiring_extra_pointer_dereference);
 }
 
 static void
 compute_resistance_and_snapping_edges (CobiwmDisplay *display)
 {
-  GList *stacked_windows;
-  GList *cur_window_iter;
-  GList *edges;
-  /* Lists of window positions (rects) and their relative stacking positions */
-  int stack_position;
-  GSList *obscuring_windows, *window_stacking;
-  /* The portions of the above lists that still remain at the stacking position
-   * in the layer that we are working on
-   */
-  GSList *rem_windows, *rem_win_stacking;
+  CobiwmEdgeResistanceData *edge_data;
+  CobiwmWorkspace *workspace;
+  GArray *windows;
+  guint i, j;
 
   g_assert (display->grab_window != NULL);
-  cobiwm_topic (COBIWM_DEBUG_WINDOW_OPS,
-              "Computing edges to resist-movement or snap-to for %s.\n",
-              display->grab_window->desc);
 
   /*
-   * 1st: Get the list of relevant windows, from bottom to top
+   * 1st: Get the list of relevant windows, from bottom to top, and check
+   * whether the edges from a previous grab can be reused as they are.
    */
-  stacked_windows =
-    cobiwm_stack_list_windows (display->screen->stack,
-                             display->screen->active_workspace);
+  workspace = display->screen->active_workspace;
+  windows = get_indexed_windows (display);
 
-  /*
-   * 2nd: we need to separate that stacked list into a list of windows that
-   * can obscure other edges.  To make sure we only have windows obscuring
-   * those below it instead of going both ways, we also need to keep a
-   * counter list.  Messy, I know.
-   */
-  obscuring_windows = window_stacking = NULL;
-  cur_window_iter = stacked_windows;
-  stack_position = 0;
-  while (cur_window_iter != NULL)
+  edge_data = display->grab_edge_resistance_data;
+  if (edge_data != NULL)
     {
-      CobiwmWindow *cur_window = cur_window_iter->data;
-      if (WINDOW_EDGES_RELEVANT (cur_window, display))
+      if (edge_index_is_current (edge_data, workspace, windows))
         {
-          CobiwmRectangle *new_rect;
-          new_rect = g_new (CobiwmRectangle, 1);
-          cobiwm_window_get_frame_rect (cur_window, new_rect);
-          obscuring_windows = g_slist_prepend (obscuring_windows, new_rect);
-          window_stacking =
-            g_slist_prepend (window_stacking, GINT_TO_POINTER (stack_position));
+          cobiwm_topic (COBIWM_DEBUG_WINDOW_OPS,
+                      "Reusing edges to resist-movement or snap-to for %s.\n",
+                      display->grab_window->desc);
+          g_array_free (windows, TRUE);
+          edge_data->validated = TRUE;
+          return;
         }
 
-      stack_position++;
-      cur_window_iter = cur_window_iter->next;
+      cobiwm_display_cleanup_edges (display);
     }
-  /* Put 'em in bottom to top order */
-  rem_windows = obscuring_windows = g_slist_reverse (obscuring_windows);
-  rem_win_stacking = window_stacking = g_slist_reverse (window_stacking);
+
+  cobiwm_topic (COBIWM_DEBUG_WINDOW_OPS,
+              "Computing edges to resist-movement or snap-to for %s.\n",
+              display->grab_window->desc);
+
+  display->grab_edge_resistance_data = g_new0 (CobiwmEdgeResistanceData, 1);
+  edge_data = display->grab_edge_resistance_data;
+  edge_data->workspace = workspace;
+  edge_data->windows = windows;
+  edge_data->window_edges = g_array_sized_new (FALSE, FALSE,
+                                               sizeof (CobiwmEdge),
+                                               4 * windows->len);
 
   /*
-   * 3rd: loop over the windows again, this time getting the edges from
-   * them and removing intersections with the relevant obscuring_windows &
-   * obscuring_docks.
+   * 2nd: loop over the windows, getting the edges from them and removing
+   * intersections with the windows stacked above them.  Note that dock
+   * edges are considered screen edges which are handled separately, but
+   * docks can still obscure other windows.
    */
-  edges = NULL;
-  stack_position = 0;
-  cur_window_iter = stacked_windows;
-  while (cur_window_iter != NULL)
+  for (i = 0; i < windows->len; i++)
     {
-      CobiwmRectangle  cur_rect;
-      CobiwmWindow    *cur_window = cur_window_iter->data;
-      cobiwm_window_get_frame_rect (cur_window, &cur_rect);
-
-      /* Check if we want to use this window's edges for edge
-       * resistance (note that dock edges are considered screen edges
-       * which are handled separately
+      IndexedWindow *cur = &g_array_index (windows, IndexedWindow, i);
+      GList *new_edges, *tmp;
+      GSList *obscuring_windows;
+      CobiwmEdge *new_edge;
+      CobiwmRectangle reduced;
+
+      if (cur->is_dock)
+        continue;
+
+      /* We don't care about snapping to any portion of the window that
+       * is offscreen (we also don't care about parts of edges covered
+       * by other windows or DOCKS, but that's handled below).
        */
-      if (WINDOW_EDGES_RELEVANT (cur_window, display) &&
-          cur_window->type != COBIWM_WINDOW_DOCK)
-        {
-          GList *new_edges;
-          CobiwmEdge *new_edge;
-          CobiwmRectangle reduced;
+      cobiwm_rectangle_intersect (&cur->rect,
+                                &display->screen->rect,
+                                &reduced);
 
-          /* We don't care about snapping to any portion of the window that
-           * is offscreen (we also don't care about parts of edges covered
-           * by other windows or DOCKS, but that's handled below).
-           */
-          cobiwm_rectangle_intersect (&cur_rect,
-                                    &display->screen->rect,
-                                    &reduced);
+      new_edges = NULL;
 
-          new_edges = NULL;
+      /* Left side of this window is resistance for the right edge of
+       * the window being moved.
+       */
+      new_edge = g_new (CobiwmEdge, 1);
+      new_edge->rect = reduced;
+      new_edge->rect.width = 0;
+      new_edge->side_type = COBIWM_SIDE_RIGHT;
+      new_edge->edge_type = COBIWM_EDGE_WINDOW;
+      new_edges = g_list_prepend (new_edges, new_edge);
+
+      /* Right side of this window is resistance for the left edge of
+       * the window being moved.
+       */
+      new_edge = g_new (CobiwmEdge, 1);
+      new_edge->rect = reduced;
+      new_edge->rect.x += new_edge->rect.width;
+      new_edge->rect.width = 0;
+      new_edge->side_type = COBIWM_SIDE_LEFT;
+      new_edge->edge_type = COBIWM_EDGE_WINDOW;
+      new_edges = g_list_prepend (new_edges, new_edge);
+
+      /* Top side of this window is resistance for the bottom edge of
+       * the window being moved.
+       */
+      new_edge = g_new (CobiwmEdge, 1);
+      new_edge->rect = reduced;
+      new_edge->rect.height = 0;
+      new_edge->side_type = COBIWM_SIDE_BOTTOM;
+      new_edge->edge_type = COBIWM_EDGE_WINDOW;
+      new_edges = g_list_prepend (new_edges, new_edge);
+
+      /* Bottom side of this window is resistance for the top edge of
+       * the window being moved.
+       */
+      new_edge = g_new (CobiwmEdge, 1);
+      new_edge->rect = reduced;
+      new_edge->rect.y += new_edge->rect.height;
+      new_edge->rect.height = 0;
+      new_edge->side_type = COBIWM_SIDE_TOP;
+      new_edge->edge_type = COBIWM_EDGE_WINDOW;
+      new_edges = g_list_prepend (new_edges, new_edge);
+
+      /* Only windows higher in the stack than this one which actually
+       * touch it can cut its edges; don't hand the others to the much
+       * more expensive edge splitting code at all.
+       */
+      obscuring_windows = NULL;
+      for (j = windows->len - 1; j > i; j--)
+        {
+          IndexedWindow *above = &g_array_index (windows, IndexedWindow, j);
 
-          /* Left side of this window is resistance for the right edge of
-           * the window being moved.
-           */
-          new_edge = g_new (CobiwmEdge, 1);
-          new_edge->rect = reduced;
-          new_edge->rect.width = 0;
-          new_edge->side_type = COBIWM_SIDE_RIGHT;
-          new_edge->edge_type = COBIWM_EDGE_WINDOW;
-          new_edges = g_list_prepend (new_edges, new_edge);
-
-          /* Right side of this window is resistance for the left edge of
-           * the window being moved.
-           */
-          new_edge = g_new (CobiwmEdge, 1);
-          new_edge->rect = reduced;
-          new_edge->rect.x += new_edge->rect.width;
-          new_edge->rect.width = 0;
-          new_edge->side_type = COBIWM_SIDE_LEFT;
-          new_edge->edge_type = COBIWM_EDGE_WINDOW;
-          new_edges = g_list_prepend (new_edges, new_edge);
-
-          /* Top side of this window is resistance for the bottom edge of
-           * the window being moved.
-           */
-          new_edge = g_new (CobiwmEdge, 1);
-          new_edge->rect = reduced;
-          new_edge->rect.height = 0;
-          new_edge->side_type = COBIWM_SIDE_BOTTOM;
-          new_edge->edge_type = COBIWM_EDGE_WINDOW;
-          new_edges = g_list_prepend (new_edges, new_edge);
-
-          /* Top side of this window is resistance for the bottom edge of
-           * the window being moved.
-           */
-          new_edge = g_new (CobiwmEdge, 1);
-          new_edge->rect = reduced;
-          new_edge->rect.y += new_edge->rect.height;
-          new_edge->rect.height = 0;
-          new_edge->side_type = COBIWM_SIDE_TOP;
-          new_edge->edge_type = COBIWM_EDGE_WINDOW;
-          new_edges = g_list_prepend (new_edges, new_edge);
-
-          /* Update the remaining windows to only those at a higher
-           * stacking position than this one.
-           */
-          while (rem_win_stacking &&
-                 stack_position >= GPOINTER_TO_INT (rem_win_stacking->data))
-            {
-              rem_windows      = rem_windows->next;
-              rem_win_stacking = rem_win_stacking->next;
-            }
+          if (rectangles_touch (&above->rect, &reduced))
+            obscuring_windows = g_slist_prepend (obscuring_windows,
+                                                 &above->rect);
+        }
 
-          /* Remove edge portions overlapped by rem_windows and rem_docks */
+      if (obscuring_windows)
+        {
           new_edges =
             cobiwm_rectangle_remove_intersections_with_boxes_from_edges (
               new_edges,
-              rem_windows);
-
-          /* Save the new edges */
-          edges = g_list_concat (new_edges, edges);
+              obscuring_windows);
+          g_slist_free (obscuring_windows);
         }
 
-      stack_position++;
-      cur_window_iter = cur_window_iter->next;
+      /* Save the new edges */
+      for (tmp = new_edges; tmp != NULL; tmp = tmp->next)
+        g_array_append_vals (edge_data->window_edges, tmp->data, 1);
+      g_list_free_full (new_edges, g_free);
     }
 
   /*
-   * 4th: Free the extra memory not needed and sort the list
-   */
-  g_list_free (stacked_windows);
-  /* Free the memory used by the obscuring windows/docks lists */
-  g_slist_free (window_stacking);
-  /* FIXME: Shouldn't there be a helper function to make this one line of code
-   * to free a list instead of four ugly ones?
-   */
-  g_slist_foreach (obscuring_windows,
-                   (void (*)(gpointer,gpointer))&g_free, /* ew, for ugly */
-                   NULL);
-  g_slist_free (obscuring_windows);
-
-  /* Sort the list.  FIXME: Should I bother with this sorting?  I just
-   * sort again later in cache_edges() anyway...
+   * 3rd: Combine these edges with the onscreen and monitor edges in
+   * sorted arrays for quick access.
    */
-  edges = g_list_sort (edges, cobiwm_rectangle_edge_cmp);
+  cache_edges (edge_data,
+               workspace->monitor_edges,
+               workspace->screen_edges);
 
-  /*
-   * 5th: Cache the combination of these edges with the onscreen and
-   * monitor edges in an array for quick access.  Free the edges since
-   * they've been cached elsewhere.
-   */
-  cache_edges (display,
-               edges,
-               display->screen->active_workspace->monitor_edges,
-               display->screen->active_workspace->screen_edges);
-  g_list_free (edges);
-
-  /*
-   * 6th: Initialize the resistance timeouts and buildups
-   */
-  initialize_grab_edge_resistance_data (display);
+  edge_data->validated = TRUE;
 }
 
 void
@@ -30,6 +30,7 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <gdk/gdk.h>
+#include <X11/Xlib-xcb.h>
 
 /* In GTK+-3.0, the error trapping code was significantly rewritten. The new code
  * has some neat features (like knowing automatically if a sync is needed or not
@@ -60,3 +61,54 @@ cobiwm_error_trap_pop_with_return  (CobiwmDisplay *display)
 {
   return gdk_error_trap_pop ();
 }
+
+/* Popping an error trap with a return value has to sync with the server
+ * each time.  Requests made with the _checked() variants of the xcb
+ * calls instead keep their errors aside until their cookie is checked,
+ * so a batch of them can be made first and then checked one by one:
+ * only the first check has to wait for the server, after which the
+ * results of all the others are in as well.
+ */
+
+/**
+ * cobiwm_error_check_cookie: (skip)
+ * @display: a #CobiwmDisplay
+ * @cookie: the cookie of a request made with a _checked() xcb call
+ *
+ * Returns: the X error code the request failed with, or 0 for
+ *   no error.
+ */
+int
+cobiwm_error_check_cookie (CobiwmDisplay       *display,
+                         xcb_void_cookie_t  cookie)
+{
+  xcb_connection_t *xcb_conn = XGetXCBConnection (display->xdisplay);
+  xcb_generic_error_t *error;
+  int error_code;
+
+  error = xcb_request_check (xcb_conn, cookie);
+  if (error == NULL)
+    return Success;
+
+  error_code = error->error_code;
+  free (error);
+
+  return error_code;
+}
+
+/**
+ * cobiwm_error_ignore_cookie: (skip)
+ * @display: a #CobiwmDisplay
+ * @cookie: the cookie of a request made with a _checked() xcb call
+ *
+ * Drops any error from the request, without waiting for it; this is
+ * the equivalent of an error trap popped with cobiwm_error_trap_pop().
+ */
+void
+cobiwm_error_ignore_cookie (CobiwmDisplay       *display,
+                          xcb_void_cookie_t  cookie)
+{
+  xcb_connection_t *xcb_conn = XGetXCBConnection (display->xdisplay);
+
+  xcb_discard_reply (xcb_conn, cookie.sequence);
+}
@@ -38,6 +38,7 @@ cobiwm_window_ensure_frame (CobiwmWindow *window)
   CobiwmFrame *frame;
   XSetWindowAttributes attrs;
   gulong create_serial;
+  gboolean reused;
 
   if (window->frame)
     return;
@@ -69,12 +70,15 @@ cobiwm_window_ensure_frame (CobiwmWindow *window)
                                           frame->rect.y,
                                           frame->rect.width,
                                           frame->rect.height,
-                                          &create_serial);
+                                          &create_serial,
+                                          &reused);
   frame->xwindow = frame->ui_frame->xwindow;
 
-  cobiwm_stack_tracker_record_add (window->screen->stack_tracker,
-                                 frame->xwindow,
-                                 create_serial);
+  /* A reused window never left the stack */
+  if (!reused)
+    cobiwm_stack_tracker_record_add (window->screen->stack_tracker,
+                                   frame->xwindow,
+                                   create_serial);
 
   cobiwm_verbose ("Frame for %s is 0x%lx\n", frame->window->desc, frame->xwindow);
   attrs.event_mask = EVENT_MASK;
@@ -118,7 +122,8 @@ cobiwm_window_ensure_frame (CobiwmWindow *window)
 
   {
     CobiwmBackend *backend = cobiwm_get_backend ();
-    if (COBIWM_IS_BACKEND_X11 (backend))
+    /* A reused window has had its input selected already */
+    if (COBIWM_IS_BACKEND_X11 (backend) && !reused)
       {
         Display *xdisplay = cobiwm_backend_x11_get_xdisplay (COBIWM_BACKEND_X11 (backend));
 
@@ -359,6 +364,12 @@ cobiwm_frame_get_mask (CobiwmFrame                    *frame,
   cobiwm_ui_frame_get_mask (frame->ui_frame, cr);
 }
 
+guint
+cobiwm_frame_get_style_serial (CobiwmFrame *frame)
+{
+  return cobiwm_ui_frame_get_style_serial (frame->ui_frame);
+}
+
 void
 cobiwm_frame_queue_draw (CobiwmFrame *frame)
 {
@@ -76,6 +76,7 @@ cairo_region_t *cobiwm_frame_get_frame_bounds (CobiwmFrame *frame);
 
 void cobiwm_frame_get_mask (CobiwmFrame *frame,
                           cairo_t   *cr);
+guint cobiwm_frame_get_style_serial (CobiwmFrame *frame);
 
 void cobiwm_frame_set_screen_cursor (CobiwmFrame	*frame,
 				   CobiwmCursor	cursor);
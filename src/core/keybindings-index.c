@@ -0,0 +1,125 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+
+/* Lookup of key bindings by resolved key combo */
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include "keybindings-index.h"
+#include <string.h>
+
+#define MIN_BINDING_INDEX_SIZE 64
+
+void
+cobiwm_key_binding_index_init (CobiwmKeyBindingIndex *index)
+{
+  index->slots = g_new0 (CobiwmKeyBindingIndexSlot, MIN_BINDING_INDEX_SIZE);
+  index->size = MIN_BINDING_INDEX_SIZE;
+  index->count = 0;
+}
+
+void
+cobiwm_key_binding_index_destroy (CobiwmKeyBindingIndex *index)
+{
+  g_clear_pointer (&index->slots, g_free);
+  index->size = 0;
+  index->count = 0;
+}
+
+void
+cobiwm_key_binding_index_clear (CobiwmKeyBindingIndex *index)
+{
+  memset (index->slots, 0, index->size * sizeof (CobiwmKeyBindingIndexSlot));
+  index->count = 0;
+}
+
+static void
+resize_index (CobiwmKeyBindingIndex *index,
+              guint                size)
+{
+  CobiwmKeyBindingIndexSlot *old_slots = index->slots;
+  guint old_size = index->size;
+  guint i;
+
+  index->slots = g_new0 (CobiwmKeyBindingIndexSlot, size);
+  index->size = size;
+
+  for (i = 0; i < old_size; i++)
+    if (old_slots[i].binding != NULL)
+      *cobiwm_key_binding_index_find_slot (index, old_slots[i].key) = old_slots[i];
+
+  g_free (old_slots);
+}
+
+/* Maps @key to @binding, replacing any binding it had */
+void
+cobiwm_key_binding_index_insert (CobiwmKeyBindingIndex *index,
+                               guint32              key,
+                               CobiwmKeyBinding      *binding)
+{
+  CobiwmKeyBindingIndexSlot *slot;
+
+  g_return_if_fail (binding != NULL);
+
+  if ((index->count + 1) * 2 > index->size)
+    resize_index (index, index->size * 2);
+
+  slot = cobiwm_key_binding_index_find_slot (index, key);
+  if (slot->binding == NULL)
+    index->count++;
+
+  slot->key = key;
+  slot->binding = binding;
+}
+
+void
+cobiwm_key_binding_index_remove (CobiwmKeyBindingIndex *index,
+                               guint32              key)
+{
+  CobiwmKeyBindingIndexSlot *slot;
+  guint mask = index->size - 1;
+  guint i, j, home;
+
+  slot = cobiwm_key_binding_index_find_slot (index, key);
+  if (slot->binding == NULL)
+    return;
+
+  /* Shift later entries of the probe sequence back into the hole, so
+   * that lookups never stop early at it; no tombstones needed.
+   */
+  i = slot - index->slots;
+  j = i;
+  for (;;)
+    {
+      index->slots[i].binding = NULL;
+
+      do
+        {
+          j = (j + 1) & mask;
+          if (index->slots[j].binding == NULL)
+            {
+              index->count--;
+              return;
+            }
+
+          home = cobiwm_key_binding_index_home (index, index->slots[j].key);
+        }
+      while (i <= j ? (i < home && home <= j) : (i < home || home <= j));
+
+      index->slots[i] = index->slots[j];
+      i = j;
+    }
+}
@@ -0,0 +1,86 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+
+/* Lookup of key bindings by resolved key combo */
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COBIWM_KEYBINDINGS_INDEX_H
+#define COBIWM_KEYBINDINGS_INDEX_H
+
+#include <glib.h>
+#include <types.h>
+
+typedef struct
+{
+  guint32 key;
+  CobiwmKeyBinding *binding; /* NULL for an empty slot */
+} CobiwmKeyBindingIndexSlot;
+
+/* Key events look up their binding in a flat, linearly probed table
+ * kept at most half full, so a lookup is normally a single probe
+ * rather than a GHashTable lookup through function pointers.
+ */
+typedef struct
+{
+  CobiwmKeyBindingIndexSlot *slots;
+  guint                    size; /* a power of two */
+  guint                    count;
+} CobiwmKeyBindingIndex;
+
+void cobiwm_key_binding_index_init    (CobiwmKeyBindingIndex *index);
+void cobiwm_key_binding_index_destroy (CobiwmKeyBindingIndex *index);
+void cobiwm_key_binding_index_clear   (CobiwmKeyBindingIndex *index);
+void cobiwm_key_binding_index_insert  (CobiwmKeyBindingIndex *index,
+                                     guint32              key,
+                                     CobiwmKeyBinding      *binding);
+void cobiwm_key_binding_index_remove  (CobiwmKeyBindingIndex *index,
+                                     guint32              key);
+
+/* The slot a probe for @key starts at */
+static inline guint
+cobiwm_key_binding_index_home (const CobiwmKeyBindingIndex *index,
+                             guint32                    key)
+{
+  return ((key * 2654435761u) >> 16) & (index->size - 1);
+}
+
+/* The slot holding @key, or the empty slot ending its probe sequence */
+static inline CobiwmKeyBindingIndexSlot *
+cobiwm_key_binding_index_find_slot (const CobiwmKeyBindingIndex *index,
+                                  guint32                    key)
+{
+  CobiwmKeyBindingIndexSlot *slot;
+  guint i;
+
+  i = cobiwm_key_binding_index_home (index, key);
+  for (;;)
+    {
+      slot = &index->slots[i];
+      if (slot->binding == NULL || slot->key == key)
+        return slot;
+
+      i = (i + 1) & (index->size - 1);
+    }
+}
+
+static inline CobiwmKeyBinding *
+cobiwm_key_binding_index_lookup (const CobiwmKeyBindingIndex *index,
+                               guint32                    key)
+{
+  return cobiwm_key_binding_index_find_slot (index, key)->binding;
+}
+
+#endif
@@ -31,6 +31,7 @@
 #include <keybindings.h>
 #include <xkbcommon/xkbcommon.h>
 #include "cobiwm-accel-parse.h"
+#include "keybindings-index.h"
 
 typedef struct _CobiwmKeyHandler CobiwmKeyHandler;
 struct _CobiwmKeyHandler
@@ -91,7 +92,7 @@ typedef struct
 typedef struct
 {
   GHashTable     *key_bindings;
-  GHashTable     *key_bindings_index;
+  CobiwmKeyBindingIndex key_bindings_index;
   xkb_mod_mask_t ignored_modifier_mask;
   xkb_mod_mask_t hyper_mask;
   xkb_mod_mask_t virtual_hyper_mask;
@@ -109,6 +110,13 @@ typedef struct
 
   /* Alt+click button grabs */
   ClutterModifierType window_grab_modifiers;
+
+  /* If set, per-window key grabs are only kept on the focus window and
+   * Alt+click grabs only on the window last entered by the pointer
+   * (button_grab_window); see cobiwm_display_update_lazy_button_grabs()
+   */
+  gboolean lazy_window_grabs;
+  CobiwmWindow *button_grab_window;
 } CobiwmKeyBindingManager;
 
 void     cobiwm_display_init_keys             (CobiwmDisplay *display);
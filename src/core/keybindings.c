@@ -49,6 +49,9 @@
 #include "backends/x11/cobiwm-backend-x11.h"
 #include "x11/window-x11.h"
 
+#include <X11/Xlib-xcb.h>
+#include <xcb/xinput.h>
+
 #ifdef HAVE_NATIVE_BACKEND
 #include "backends/native/cobiwm-backend-native.h"
 #endif
@@ -131,8 +134,11 @@ static gboolean process_keyboard_resize_grab (CobiwmDisplay     *display,
                                               CobiwmWindow      *window,
                                               ClutterKeyEvent *event);
 
-static void grab_key_bindings           (CobiwmDisplay *display);
-static void ungrab_key_bindings         (CobiwmDisplay *display);
+typedef struct _KeyGrabSet KeyGrabSet;
+
+static KeyGrabSet *collect_key_grabs    (CobiwmKeyBindingManager *keys);
+static void        update_key_grabs     (CobiwmDisplay          *display,
+                                         KeyGrabSet             *old_grabs);
 
 static GHashTable *key_handlers;
 static GHashTable *external_grabs;
@@ -517,11 +523,17 @@ static void
 index_binding (CobiwmKeyBindingManager *keys,
                CobiwmKeyBinding         *binding)
 {
-  guint32 index_key;
+  cobiwm_key_binding_index_insert (&keys->key_bindings_index,
+                                 key_combo_key (&binding->resolved_combo),
+                                 binding);
+}
 
-  index_key = key_combo_key (&binding->resolved_combo);
-  g_hash_table_replace (keys->key_bindings_index,
-                        GINT_TO_POINTER (index_key), binding);
+static void
+unindex_binding (CobiwmKeyBindingManager *keys,
+                 CobiwmKeyBinding         *binding)
+{
+  cobiwm_key_binding_index_remove (&keys->key_bindings_index,
+                                 key_combo_key (&binding->resolved_combo));
 }
 
 static void
@@ -552,7 +564,7 @@ binding_reload_combos_foreach (gpointer key,
 static void
 reload_combos (CobiwmKeyBindingManager *keys)
 {
-  g_hash_table_remove_all (keys->key_bindings_index);
+  cobiwm_key_binding_index_clear (&keys->key_bindings_index);
 
   determine_keymap_num_levels (keys);
 
@@ -653,47 +665,12 @@ rebuild_special_bindings (CobiwmKeyBindingManager *keys)
   keys->overlay_key_combo = combo;
 }
 
-static void
-ungrab_key_bindings (CobiwmDisplay *display)
-{
-  GSList *windows, *l;
-
-  cobiwm_screen_ungrab_keys (display->screen);
-
-  windows = cobiwm_display_list_windows (display, COBIWM_LIST_DEFAULT);
-  for (l = windows; l; l = l->next)
-    {
-      CobiwmWindow *w = l->data;
-      cobiwm_window_ungrab_keys (w);
-    }
-
-  g_slist_free (windows);
-}
-
-static void
-grab_key_bindings (CobiwmDisplay *display)
-{
-  GSList *windows, *l;
-
-  cobiwm_screen_grab_keys (display->screen);
-
-  windows = cobiwm_display_list_windows (display, COBIWM_LIST_DEFAULT);
-  for (l = windows; l; l = l->next)
-    {
-      CobiwmWindow *w = l->data;
-      cobiwm_window_grab_keys (w);
-    }
-
-  g_slist_free (windows);
-}
-
 static CobiwmKeyBinding *
 get_keybinding (CobiwmKeyBindingManager *keys,
                 CobiwmResolvedKeyCombo  *resolved_combo)
 {
-  guint32 key;
-  key = key_combo_key (resolved_combo);
-  return g_hash_table_lookup (keys->key_bindings_index, GINT_TO_POINTER (key));
+  return cobiwm_key_binding_index_lookup (&keys->key_bindings_index,
+                                        key_combo_key (resolved_combo));
 }
 
 static guint
@@ -882,8 +859,9 @@ on_keymap_changed (CobiwmBackend *backend,
 {
   CobiwmDisplay *display = user_data;
   CobiwmKeyBindingManager *keys = &display->key_binding_manager;
+  KeyGrabSet *old_grabs;
 
-  ungrab_key_bindings (display);
+  old_grabs = collect_key_grabs (keys);
 
   /* Deciphering the modmap depends on the loaded keysyms to find out
    * what modifiers is Super and so forth, so we need to reload it
@@ -892,7 +870,7 @@ on_keymap_changed (CobiwmBackend *backend,
 
   reload_combos (keys);
 
-  grab_key_bindings (display);
+  update_key_grabs (display, old_grabs);
 }
 
 static void
@@ -1021,6 +999,74 @@ cobiwm_display_ungrab_window_buttons (CobiwmDisplay *display,
                             keys->window_grab_modifiers);
 }
 
+static gboolean
+window_wants_button_grabs (CobiwmWindow *window)
+{
+  return window->type != COBIWM_WINDOW_DOCK && !window->override_redirect;
+}
+
+static void
+change_lazy_button_grabs (CobiwmWindow *window,
+                          gboolean    grab)
+{
+  CobiwmDisplay *display = window->display;
+
+  if (grab)
+    {
+      cobiwm_display_grab_window_buttons (display, window->xwindow);
+      if (window->frame)
+        cobiwm_display_grab_window_buttons (display, window->frame->xwindow);
+    }
+  else
+    {
+      cobiwm_display_ungrab_window_buttons (display, window->xwindow);
+      if (window->frame)
+        cobiwm_display_ungrab_window_buttons (display, window->frame->xwindow);
+    }
+}
+
+/**
+ * cobiwm_display_update_lazy_button_grabs:
+ * @display: a #CobiwmDisplay
+ * @window: the window the pointer entered
+ *
+ * With lazy window grabs, moves the Alt+click button grabs to @window.
+ * The pointer always enters a window before clicking it, so this is
+ * enough for the grabs to be in place where they are needed, and
+ * saves grabbing on every window at manage time.
+ */
+void
+cobiwm_display_update_lazy_button_grabs (CobiwmDisplay *display,
+                                       CobiwmWindow  *window)
+{
+  CobiwmKeyBindingManager *keys = &display->key_binding_manager;
+
+  if (!keys->lazy_window_grabs ||
+      window == keys->button_grab_window ||
+      !window_wants_button_grabs (window))
+    return;
+
+  cobiwm_error_trap_push (display);
+
+  if (keys->button_grab_window)
+    change_lazy_button_grabs (keys->button_grab_window, FALSE);
+
+  keys->button_grab_window = window;
+  change_lazy_button_grabs (window, TRUE);
+
+  cobiwm_error_trap_pop (display);
+}
+
+void
+cobiwm_display_forget_lazy_grab_window (CobiwmDisplay *display,
+                                      CobiwmWindow  *window)
+{
+  CobiwmKeyBindingManager *keys = &display->key_binding_manager;
+
+  if (keys->button_grab_window == window)
+    keys->button_grab_window = NULL;
+}
+
 static void
 update_window_grab_modifiers (CobiwmKeyBindingManager *keys)
 {
@@ -1098,15 +1144,35 @@ prefs_changed_callback (CobiwmPreference pref,
   switch (pref)
     {
     case COBIWM_PREF_KEYBINDINGS:
-      ungrab_key_bindings (display);
-      rebuild_key_binding_table (keys);
-      rebuild_special_bindings (keys);
-      reload_combos (keys);
-      grab_key_bindings (display);
+      {
+        KeyGrabSet *old_grabs;
+
+        old_grabs = collect_key_grabs (keys);
+        rebuild_key_binding_table (keys);
+        rebuild_special_bindings (keys);
+        reload_combos (keys);
+        update_key_grabs (display, old_grabs);
+      }
       break;
     case COBIWM_PREF_MOUSE_BUTTON_MODS:
       {
         GSList *windows, *l;
+
+        /* Only the window last entered holds grabs, on its frame too */
+        if (keys->lazy_window_grabs)
+          {
+            CobiwmWindow *w = keys->button_grab_window;
+
+            cobiwm_error_trap_push (display);
+            if (w)
+              change_lazy_button_grabs (w, FALSE);
+            update_window_grab_modifiers (keys);
+            if (w)
+              change_lazy_button_grabs (w, TRUE);
+            cobiwm_error_trap_pop (display);
+            break;
+          }
+
         windows = cobiwm_display_list_windows (display, COBIWM_LIST_DEFAULT);
 
         for (l = windows; l; l = l->next)
@@ -1139,30 +1205,27 @@ cobiwm_display_shutdown_keys (CobiwmDisplay *display)
 
   cobiwm_prefs_remove_listener (prefs_changed_callback, display);
 
-  g_hash_table_destroy (keys->key_bindings_index);
+  cobiwm_key_binding_index_destroy (&keys->key_bindings_index);
   g_hash_table_destroy (keys->key_bindings);
 }
 
 /* Grab/ungrab, ignoring all annoying modifiers like NumLock etc. */
 static void
-cobiwm_change_keygrab (CobiwmKeyBindingManager *keys,
-                     Window                 xwindow,
-                     gboolean               grab,
-                     CobiwmResolvedKeyCombo  *resolved_combo)
+change_keygrab_with_ignored_mask (Window                 xwindow,
+                                  gboolean               grab,
+                                  CobiwmResolvedKeyCombo  *resolved_combo,
+                                  xkb_mod_mask_t         ignored_modifier_mask)
 {
   unsigned int ignored_mask;
-
-  unsigned char mask_bits[XIMaskLen (XI_LASTEVENT)] = { 0 };
-  XIEventMask mask = { XIAllMasterDevices, sizeof (mask_bits), mask_bits };
-
-  XISetMask (mask.mask, XI_KeyPress);
-  XISetMask (mask.mask, XI_KeyRelease);
+  const uint32_t event_mask = (XCB_INPUT_XI_EVENT_MASK_KEY_PRESS |
+                               XCB_INPUT_XI_EVENT_MASK_KEY_RELEASE);
 
   if (cobiwm_is_wayland_compositor ())
     return;
 
   CobiwmBackendX11 *backend = COBIWM_BACKEND_X11 (cobiwm_get_backend ());
   Display *xdisplay = cobiwm_backend_x11_get_xdisplay (backend);
+  xcb_connection_t *xcb_conn = XGetXCBConnection (xdisplay);
 
   /* Grab keycode/modmask, together with
    * all combinations of ignored modifiers.
@@ -1175,11 +1238,11 @@ cobiwm_change_keygrab (CobiwmKeyBindingManager *keys,
               resolved_combo->keycode, resolved_combo->mask, xwindow);
 
   ignored_mask = 0;
-  while (ignored_mask <= keys->ignored_modifier_mask)
+  while (ignored_mask <= ignored_modifier_mask)
     {
       XIGrabModifiers mods;
 
-      if (ignored_mask & ~(keys->ignored_modifier_mask))
+      if (ignored_mask & ~(ignored_modifier_mask))
         {
           /* Not a combination of ignored modifiers
            * (it contains some non-ignored modifiers)
@@ -1191,11 +1254,31 @@ cobiwm_change_keygrab (CobiwmKeyBindingManager *keys,
       mods = (XIGrabModifiers) { resolved_combo->mask | ignored_mask, 0 };
 
       if (grab)
-        XIGrabKeycode (xdisplay,
-                       COBIWM_VIRTUAL_CORE_KEYBOARD_ID,
-                       resolved_combo->keycode, xwindow,
-                       XIGrabModeSync, XIGrabModeAsync,
-                       False, &mask, 1, &mods);
+        {
+          xcb_input_xi_passive_grab_device_cookie_t cookie;
+          uint32_t modifiers = mods.modifiers;
+
+          /* XIGrabKeycode() waits for the list of modifiers that could
+           * not be grabbed, which we ignore anyway; sending the request
+           * through xcb and dropping the reply lets all the grabs for a
+           * binding change go out as one batch instead of a round trip
+           * each.
+           */
+          cookie = xcb_input_xi_passive_grab_device (xcb_conn,
+                                                     XCB_CURRENT_TIME,
+                                                     xwindow,
+                                                     XCB_NONE,
+                                                     resolved_combo->keycode,
+                                                     COBIWM_VIRTUAL_CORE_KEYBOARD_ID,
+                                                     1, 1,
+                                                     XCB_INPUT_GRAB_TYPE_KEYCODE,
+                                                     XCB_INPUT_GRAB_MODE_22_SYNC,
+                                                     XCB_INPUT_GRAB_MODE_22_ASYNC,
+                                                     FALSE,
+                                                     &event_mask,
+                                                     &modifiers);
+          xcb_discard_reply (xcb_conn, cookie.sequence);
+        }
       else
         XIUngrabKeycode (xdisplay,
                          COBIWM_VIRTUAL_CORE_KEYBOARD_ID,
@@ -1205,6 +1288,16 @@ cobiwm_change_keygrab (CobiwmKeyBindingManager *keys,
     }
 }
 
+static void
+cobiwm_change_keygrab (CobiwmKeyBindingManager *keys,
+                     Window                 xwindow,
+                     gboolean               grab,
+                     CobiwmResolvedKeyCombo  *resolved_combo)
+{
+  change_keygrab_with_ignored_mask (xwindow, grab, resolved_combo,
+                                    keys->ignored_modifier_mask);
+}
+
 typedef struct
 {
   CobiwmKeyBindingManager *keys;
@@ -1311,6 +1404,16 @@ cobiwm_window_grab_keys (CobiwmWindow  *window)
   if (window->all_keys_grabbed)
     return;
 
+  /* Per-window bindings only act on the focus window, so with lazy
+   * grabs that is the only window that gets them; focus changes move
+   * them along.
+   */
+  if (keys->lazy_window_grabs && !window->has_focus)
+    {
+      cobiwm_window_ungrab_keys (window);
+      return;
+    }
+
   if (window->type == COBIWM_WINDOW_DOCK
       || window->override_redirect)
     {
@@ -1357,6 +1460,234 @@ cobiwm_window_ungrab_keys (CobiwmWindow  *window)
     }
 }
 
+/* The combos grabbed on the root window and on each window, so that
+ * a keymap or binding change only needs to touch the grabs that
+ * actually changed; with many windows, regrabbing everything means
+ * thousands of requests.
+ */
+struct _KeyGrabSet
+{
+  GArray *root_combos;
+  GArray *window_combos;
+  xkb_mod_mask_t ignored_modifier_mask;
+};
+
+static gint
+compare_resolved_combos (gconstpointer a,
+                         gconstpointer b)
+{
+  guint32 key_a = key_combo_key ((CobiwmResolvedKeyCombo *) a);
+  guint32 key_b = key_combo_key ((CobiwmResolvedKeyCombo *) b);
+
+  return key_a < key_b ? -1 : key_a > key_b;
+}
+
+static void
+add_grab_combo (GArray               *combos,
+                CobiwmResolvedKeyCombo *combo)
+{
+  if (combo->keycode != 0)
+    g_array_append_val (combos, *combo);
+}
+
+static void
+sort_grab_combos (GArray *combos)
+{
+  guint i, j;
+
+  g_array_sort (combos, compare_resolved_combos);
+
+  for (i = 0, j = 0; i < combos->len; i++)
+    {
+      CobiwmResolvedKeyCombo *combo = &g_array_index (combos, CobiwmResolvedKeyCombo, i);
+
+      if (j > 0 &&
+          compare_resolved_combos (combo, &g_array_index (combos, CobiwmResolvedKeyCombo, j - 1)) == 0)
+        continue;
+
+      g_array_index (combos, CobiwmResolvedKeyCombo, j++) = *combo;
+    }
+
+  g_array_set_size (combos, j);
+}
+
+static KeyGrabSet *
+collect_key_grabs (CobiwmKeyBindingManager *keys)
+{
+  KeyGrabSet *set;
+  GHashTableIter iter;
+  CobiwmKeyBinding *binding;
+  int i;
+
+  set = g_new0 (KeyGrabSet, 1);
+  set->root_combos = g_array_new (FALSE, FALSE, sizeof (CobiwmResolvedKeyCombo));
+  set->window_combos = g_array_new (FALSE, FALSE, sizeof (CobiwmResolvedKeyCombo));
+  set->ignored_modifier_mask = keys->ignored_modifier_mask;
+
+  /* Must match what cobiwm_screen_change_keygrabs() and
+   * change_window_keygrabs() grab
+   */
+  add_grab_combo (set->root_combos, &keys->overlay_resolved_key_combo);
+  for (i = 0; i < keys->n_iso_next_group_combos; i++)
+    add_grab_combo (set->root_combos, &keys->iso_next_group_combos[i]);
+
+  g_hash_table_iter_init (&iter, keys->key_bindings);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &binding, NULL))
+    {
+      if (binding->flags & COBIWM_KEY_BINDING_PER_WINDOW)
+        add_grab_combo (set->window_combos, &binding->resolved_combo);
+      else
+        add_grab_combo (set->root_combos, &binding->resolved_combo);
+    }
+
+  sort_grab_combos (set->root_combos);
+  sort_grab_combos (set->window_combos);
+
+  return set;
+}
+
+static void
+key_grab_set_free (KeyGrabSet *set)
+{
+  g_array_free (set->root_combos, TRUE);
+  g_array_free (set->window_combos, TRUE);
+  g_free (set);
+}
+
+static void
+change_keygrabs_from_set (Window          xwindow,
+                          gboolean        grab,
+                          GArray         *combos,
+                          xkb_mod_mask_t  ignored_modifier_mask)
+{
+  guint i;
+
+  for (i = 0; i < combos->len; i++)
+    change_keygrab_with_ignored_mask (xwindow, grab,
+                                      &g_array_index (combos, CobiwmResolvedKeyCombo, i),
+                                      ignored_modifier_mask);
+}
+
+/* Turns the grabs for @old_combos on @xwindow into those for @new_combos;
+ * both are sorted, so this is a merge of the two.
+ */
+static void
+apply_keygrab_diff (Window          xwindow,
+                    GArray         *old_combos,
+                    xkb_mod_mask_t  old_ignored_mask,
+                    GArray         *new_combos,
+                    xkb_mod_mask_t  new_ignored_mask)
+{
+  guint i = 0, j = 0;
+
+  /* A different set of ignored modifiers changes every grab */
+  if (old_ignored_mask != new_ignored_mask)
+    {
+      change_keygrabs_from_set (xwindow, FALSE, old_combos, old_ignored_mask);
+      change_keygrabs_from_set (xwindow, TRUE, new_combos, new_ignored_mask);
+      return;
+    }
+
+  while (i < old_combos->len || j < new_combos->len)
+    {
+      CobiwmResolvedKeyCombo *old_combo = NULL, *new_combo = NULL;
+      int cmp;
+
+      if (i < old_combos->len)
+        old_combo = &g_array_index (old_combos, CobiwmResolvedKeyCombo, i);
+      if (j < new_combos->len)
+        new_combo = &g_array_index (new_combos, CobiwmResolvedKeyCombo, j);
+
+      if (old_combo == NULL)
+        cmp = 1;
+      else if (new_combo == NULL)
+        cmp = -1;
+      else
+        cmp = compare_resolved_combos (old_combo, new_combo);
+
+      if (cmp < 0)
+        {
+          change_keygrab_with_ignored_mask (xwindow, FALSE, old_combo, old_ignored_mask);
+          i++;
+        }
+      else if (cmp > 0)
+        {
+          change_keygrab_with_ignored_mask (xwindow, TRUE, new_combo, new_ignored_mask);
+          j++;
+        }
+      else
+        {
+          i++;
+          j++;
+        }
+    }
+}
+
+/* Brings the grabs on the root window and all windows from @old_grabs,
+ * collected before the bindings or keymap changed, up to date; this has
+ * the same result as ungrabbing everything beforehand and grabbing it
+ * all again afterwards. Frees @old_grabs.
+ */
+static void
+update_key_grabs (CobiwmDisplay *display,
+                  KeyGrabSet  *old_grabs)
+{
+  CobiwmKeyBindingManager *keys = &display->key_binding_manager;
+  CobiwmScreen *screen = display->screen;
+  KeyGrabSet *new_grabs;
+  GSList *windows, *l;
+
+  new_grabs = collect_key_grabs (keys);
+
+  if (screen->keys_grabbed)
+    apply_keygrab_diff (screen->xroot,
+                        old_grabs->root_combos, old_grabs->ignored_modifier_mask,
+                        new_grabs->root_combos, new_grabs->ignored_modifier_mask);
+  else
+    cobiwm_screen_grab_keys (screen);
+
+  windows = cobiwm_display_list_windows (display, COBIWM_LIST_DEFAULT);
+  for (l = windows; l; l = l->next)
+    {
+      CobiwmWindow *w = l->data;
+
+      if (w->keys_grabbed &&
+          !w->all_keys_grabbed &&
+          w->type != COBIWM_WINDOW_DOCK &&
+          !w->override_redirect &&
+          w->grab_on_frame == (w->frame != NULL))
+        {
+          /* Grabbed where cobiwm_window_grab_keys() would grab again */
+          apply_keygrab_diff (cobiwm_window_x11_get_toplevel_xwindow (w),
+                              old_grabs->window_combos, old_grabs->ignored_modifier_mask,
+                              new_grabs->window_combos, new_grabs->ignored_modifier_mask);
+          continue;
+        }
+
+      if (w->keys_grabbed)
+        {
+          /* As cobiwm_window_ungrab_keys(), but for the old bindings */
+          if (w->grab_on_frame && w->frame != NULL)
+            change_keygrabs_from_set (w->frame->xwindow, FALSE,
+                                      old_grabs->window_combos,
+                                      old_grabs->ignored_modifier_mask);
+          else if (!w->grab_on_frame)
+            change_keygrabs_from_set (w->xwindow, FALSE,
+                                      old_grabs->window_combos,
+                                      old_grabs->ignored_modifier_mask);
+
+          w->keys_grabbed = FALSE;
+        }
+
+      cobiwm_window_grab_keys (w);
+    }
+
+  g_slist_free (windows);
+
+  key_grab_set_free (old_grabs);
+  key_grab_set_free (new_grabs);
+}
+
 static void
 handle_external_grab (CobiwmDisplay     *display,
                       CobiwmScreen      *screen,
@@ -1440,12 +1771,9 @@ cobiwm_display_ungrab_accelerator (CobiwmDisplay *display,
   binding = get_keybinding (keys, &resolved_combo);
   if (binding)
     {
-      guint32 index_key;
-
       cobiwm_change_keygrab (keys, display->screen->xroot, FALSE, &binding->resolved_combo);
 
-      index_key = key_combo_key (&binding->resolved_combo);
-      g_hash_table_remove (keys->key_bindings_index, GINT_TO_POINTER (index_key));
+      unindex_binding (keys, binding);
 
       g_hash_table_remove (keys->key_bindings, binding);
     }
@@ -3888,8 +4216,11 @@ cobiwm_display_init_keys (CobiwmDisplay *display)
   keys->super_mask = 0;
   keys->cobiwm_mask = 0;
 
+  keys->lazy_window_grabs = g_getenv ("COBIWM_LAZY_WINDOW_GRABS") != NULL;
+  keys->button_grab_window = NULL;
+
   keys->key_bindings = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) cobiwm_key_binding_free);
-  keys->key_bindings_index = g_hash_table_new (NULL, NULL);
+  cobiwm_key_binding_index_init (&keys->key_bindings_index);
 
   reload_modmap (keys);
 
@@ -40,47 +40,318 @@ typedef enum
   COBIWM_BOTTOM
 } CobiwmWindowDirection;
 
+/* A window taken into account by the placement algorithms, with its
+ * frame rect fetched once up front rather than in every comparison
+ */
+typedef struct
+{
+  CobiwmWindow    *window;
+  CobiwmRectangle  rect;
+  int            from_origin;
+} PlacementEntry;
+
+/* Snapshot of the windows on the relevant workspaces, built once per
+ * placement.  Windows that new windows should not overlap (see
+ * window_is_placement_obstacle()) are bucketed in a uniform grid over
+ * their bounding box; cell c lists them in
+ * cell_items[cell_start[c] .. cell_start[c + 1] - 1], so an overlap
+ * test only looks at windows near the candidate rect.
+ */
+typedef struct
+{
+  PlacementEntry *entries;
+  guint           n_entries;
+
+  CobiwmRectangle   bounds;
+  int             cell_width;
+  int             cell_height;
+  int             n_cols;
+  int             n_rows;
+  guint          *cell_start;
+  guint          *cell_items;
+} PlacementIndex;
+
+#define PLACEMENT_GRID_MAX_CELLS 32 /* per axis */
+
+static gboolean
+window_is_placement_obstacle (CobiwmWindow *window)
+{
+  switch (window->type)
+    {
+    case COBIWM_WINDOW_DOCK:
+    case COBIWM_WINDOW_SPLASHSCREEN:
+    case COBIWM_WINDOW_DESKTOP:
+    case COBIWM_WINDOW_DIALOG:
+    case COBIWM_WINDOW_MODAL_DIALOG:
+    /* override redirect window types: */
+    case COBIWM_WINDOW_DROPDOWN_MENU:
+    case COBIWM_WINDOW_POPUP_MENU:
+    case COBIWM_WINDOW_TOOLTIP:
+    case COBIWM_WINDOW_NOTIFICATION:
+    case COBIWM_WINDOW_COMBO:
+    case COBIWM_WINDOW_DND:
+    case COBIWM_WINDOW_OVERRIDE_OTHER:
+      return FALSE;
+
+    case COBIWM_WINDOW_NORMAL:
+    case COBIWM_WINDOW_UTILITY:
+    case COBIWM_WINDOW_TOOLBAR:
+    case COBIWM_WINDOW_MENU:
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+static gboolean
+entry_is_obstacle (const PlacementEntry *entry)
+{
+  return entry->rect.width > 0 && entry->rect.height > 0 &&
+    window_is_placement_obstacle (entry->window);
+}
+
+/* Finds the grid cells covered by @rect; returns FALSE if @rect lies
+ * outside the bounds of all obstacles.
+ */
+static gboolean
+placement_index_get_cells (const PlacementIndex  *index,
+                           const CobiwmRectangle *rect,
+                           int                 *col1,
+                           int                 *row1,
+                           int                 *col2,
+                           int                 *row2)
+{
+  int x1, y1, x2, y2;
+
+  x1 = MAX (rect->x, index->bounds.x);
+  y1 = MAX (rect->y, index->bounds.y);
+  x2 = MIN (rect->x + rect->width, index->bounds.x + index->bounds.width);
+  y2 = MIN (rect->y + rect->height, index->bounds.y + index->bounds.height);
+
+  if (x2 <= x1 || y2 <= y1)
+    return FALSE;
+
+  *col1 = (x1 - index->bounds.x) / index->cell_width;
+  *row1 = (y1 - index->bounds.y) / index->cell_height;
+  *col2 = (x2 - 1 - index->bounds.x) / index->cell_width;
+  *row2 = (y2 - 1 - index->bounds.y) / index->cell_height;
+
+  return TRUE;
+}
+
+static void
+placement_index_init (PlacementIndex *index,
+                      GList          *windows)
+{
+  GList *tmp;
+  guint *fill;
+  guint n_obstacles;
+  int n_cells, side;
+  int col1, row1, col2, row2, row, col;
+  guint i;
+
+  index->n_entries = g_list_length (windows);
+  index->entries = g_new (PlacementEntry, index->n_entries);
+  index->cell_start = NULL;
+  index->cell_items = NULL;
+  index->n_cols = 0;
+  index->n_rows = 0;
+
+  n_obstacles = 0;
+  for (tmp = windows, i = 0; tmp != NULL; tmp = tmp->next, i++)
+    {
+      PlacementEntry *entry = &index->entries[i];
+      int x, y;
+
+      entry->window = tmp->data;
+      cobiwm_window_get_frame_rect (entry->window, &entry->rect);
+
+      x = entry->rect.x;
+      y = entry->rect.y;
+      entry->from_origin = sqrt (x * x + y * y);
+
+      if (!entry_is_obstacle (entry))
+        continue;
+
+      if (n_obstacles == 0)
+        index->bounds = entry->rect;
+      else
+        cobiwm_rectangle_union (&index->bounds, &entry->rect, &index->bounds);
+      n_obstacles++;
+    }
+
+  if (n_obstacles == 0)
+    return;
+
+  /* About one obstacle per cell if they were spread evenly */
+  side = CLAMP ((int) ceil (sqrt (n_obstacles)), 1, PLACEMENT_GRID_MAX_CELLS);
+  index->n_cols = MIN (side, index->bounds.width);
+  index->n_rows = MIN (side, index->bounds.height);
+  index->cell_width = (index->bounds.width + index->n_cols - 1) / index->n_cols;
+  index->cell_height = (index->bounds.height + index->n_rows - 1) / index->n_rows;
+
+  n_cells = index->n_cols * index->n_rows;
+  index->cell_start = g_new0 (guint, n_cells + 1);
+
+  for (i = 0; i < index->n_entries; i++)
+    {
+      PlacementEntry *entry = &index->entries[i];
+
+      if (!entry_is_obstacle (entry) ||
+          !placement_index_get_cells (index, &entry->rect,
+                                      &col1, &row1, &col2, &row2))
+        continue;
+
+      for (row = row1; row <= row2; row++)
+        for (col = col1; col <= col2; col++)
+          index->cell_start[row * index->n_cols + col + 1]++;
+    }
+
+  for (col = 0; col < n_cells; col++)
+    index->cell_start[col + 1] += index->cell_start[col];
+
+  index->cell_items = g_new (guint, index->cell_start[n_cells]);
+  fill = g_memdup (index->cell_start, n_cells * sizeof (guint));
+
+  for (i = 0; i < index->n_entries; i++)
+    {
+      PlacementEntry *entry = &index->entries[i];
+
+      if (!entry_is_obstacle (entry) ||
+          !placement_index_get_cells (index, &entry->rect,
+                                      &col1, &row1, &col2, &row2))
+        continue;
+
+      for (row = row1; row <= row2; row++)
+        for (col = col1; col <= col2; col++)
+          index->cell_items[fill[row * index->n_cols + col]++] = i;
+    }
+
+  g_free (fill);
+}
+
+static void
+placement_index_clear (PlacementIndex *index)
+{
+  g_clear_pointer (&index->entries, g_free);
+  g_clear_pointer (&index->cell_start, g_free);
+  g_clear_pointer (&index->cell_items, g_free);
+  index->n_entries = 0;
+}
+
+static gboolean
+placement_index_overlaps (const PlacementIndex  *index,
+                          const CobiwmRectangle *rect)
+{
+  int col1, row1, col2, row2, row, col;
+  CobiwmRectangle dest;
+  guint k;
+
+  if (index->cell_start == NULL ||
+      !placement_index_get_cells (index, rect, &col1, &row1, &col2, &row2))
+    return FALSE;
+
+  for (row = row1; row <= row2; row++)
+    for (col = col1; col <= col2; col++)
+      {
+        int cell = row * index->n_cols + col;
+
+        for (k = index->cell_start[cell]; k < index->cell_start[cell + 1]; k++)
+          {
+            const PlacementEntry *entry = &index->entries[index->cell_items[k]];
+
+            if (cobiwm_rectangle_intersect (rect, &entry->rect, &dest))
+              return TRUE;
+          }
+      }
+
+  return FALSE;
+}
+
+/* Returns the entry indices of @index in the order given by @compare,
+ * which gets pointers to two indices and @index as user data.
+ */
+static guint *
+placement_index_sort (const PlacementIndex *index,
+                      GCompareDataFunc      compare)
+{
+  guint *order;
+  guint i;
+
+  order = g_new (guint, index->n_entries);
+  for (i = 0; i < index->n_entries; i++)
+    order[i] = i;
+
+  g_qsort_with_data (order, index->n_entries, sizeof (guint),
+                     compare, (gpointer) index);
+
+  return order;
+}
+
+/* Ties are broken on the position in the window list, so the orders
+ * below match sorting the list with a stable sort.
+ */
+#define COMPARE_INT(a, b) G_STMT_START {        \
+    if ((a) < (b))                              \
+      return -1;                                \
+    else if ((a) > (b))                         \
+      return 1;                                 \
+  } G_STMT_END
+
 static gint
-northwestcmp (gconstpointer a, gconstpointer b)
+northwestcmp (gconstpointer a, gconstpointer b, gpointer user_data)
 {
-  CobiwmWindow *aw = (gpointer) a;
-  CobiwmWindow *bw = (gpointer) b;
-  CobiwmRectangle a_frame;
-  CobiwmRectangle b_frame;
-  int from_origin_a;
-  int from_origin_b;
-  int ax, ay, bx, by;
-
-  cobiwm_window_get_frame_rect (aw, &a_frame);
-  cobiwm_window_get_frame_rect (bw, &b_frame);
-  ax = a_frame.x;
-  ay = a_frame.y;
-  bx = b_frame.x;
-  by = b_frame.y;
+  const PlacementIndex *index = user_data;
+  guint ai = *(const guint *) a;
+  guint bi = *(const guint *) b;
 
   /* probably there's a fast good-enough-guess we could use here. */
-  from_origin_a = sqrt (ax * ax + ay * ay);
-  from_origin_b = sqrt (bx * bx + by * by);
+  COMPARE_INT (index->entries[ai].from_origin, index->entries[bi].from_origin);
+  COMPARE_INT (ai, bi);
+  return 0;
+}
 
-  if (from_origin_a < from_origin_b)
-    return -1;
-  else if (from_origin_a > from_origin_b)
-    return 1;
-  else
-    return 0;
+/* topmost, then leftmost */
+static gint
+below_cmp (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  const PlacementIndex *index = user_data;
+  guint ai = *(const guint *) a;
+  guint bi = *(const guint *) b;
+
+  COMPARE_INT (index->entries[ai].rect.y, index->entries[bi].rect.y);
+  COMPARE_INT (index->entries[ai].rect.x, index->entries[bi].rect.x);
+  COMPARE_INT (ai, bi);
+  return 0;
 }
 
+/* leftmost, then topmost */
+static gint
+right_cmp (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  const PlacementIndex *index = user_data;
+  guint ai = *(const guint *) a;
+  guint bi = *(const guint *) b;
+
+  COMPARE_INT (index->entries[ai].rect.x, index->entries[bi].rect.x);
+  COMPARE_INT (index->entries[ai].rect.y, index->entries[bi].rect.y);
+  COMPARE_INT (ai, bi);
+  return 0;
+}
+
+#undef COMPARE_INT
+
 static void
 find_next_cascade (CobiwmWindow *window,
                    /* visible windows on relevant workspaces */
-                   GList      *windows,
+                   PlacementIndex *index,
                    int         x,
                    int         y,
                    int        *new_x,
                    int        *new_y)
 {
-  GList *tmp;
-  GList *sorted;
+  guint *sorted;
+  guint i;
   int cascade_x, cascade_y;
   CobiwmRectangle titlebar_rect;
   int x_threshold, y_threshold;
@@ -90,8 +361,7 @@ find_next_cascade (CobiwmWindow *window,
   CobiwmRectangle work_area;
   int current;
 
-  sorted = g_list_copy (windows);
-  sorted = g_list_sort (sorted, northwestcmp);
+  sorted = placement_index_sort (index, northwestcmp);
 
   /* This is a "fuzzy" cascade algorithm.
    * For each window in the list, we find where we'd cascade a
@@ -125,24 +395,22 @@ find_next_cascade (CobiwmWindow *window,
   window_height = frame_rect.height;
 
   cascade_stage = 0;
-  tmp = sorted;
-  while (tmp != NULL)
+  i = 0;
+  while (i < index->n_entries)
     {
-      CobiwmWindow *w;
-      CobiwmRectangle w_frame_rect;
+      PlacementEntry *entry;
       int wx, wy;
 
-      w = tmp->data;
+      entry = &index->entries[sorted[i]];
 
       /* we want frame position, not window position */
-      cobiwm_window_get_frame_rect (w, &w_frame_rect);
-      wx = w_frame_rect.x;
-      wy = w_frame_rect.y;
+      wx = entry->rect.x;
+      wy = entry->rect.y;
 
       if (ABS (wx - cascade_x) < x_threshold &&
           ABS (wy - cascade_y) < y_threshold)
         {
-          cobiwm_window_get_titlebar_rect (w, &titlebar_rect);
+          cobiwm_window_get_titlebar_rect (entry->window, &titlebar_rect);
 
           /* Cascade the window evenly by the titlebar height; this isn't a typo. */
           cascade_x = wx + titlebar_rect.height;
@@ -167,7 +435,7 @@ find_next_cascade (CobiwmWindow *window,
               if ((cascade_x + window_width) <
                   (work_area.x + work_area.width))
                 {
-                  tmp = sorted;
+                  i = 0;
                   continue;
                 }
               else
@@ -183,14 +451,14 @@ find_next_cascade (CobiwmWindow *window,
           /* Keep searching for a further-down-the-diagonal window. */
         }
 
-      tmp = tmp->next;
+      i++;
     }
 
   /* cascade_x and cascade_y will match the last window in the list
    * that was "in the way" (in the approximate cascade diagonal)
    */
 
-  g_list_free (sorted);
+  g_free (sorted);
 
   *new_x = cascade_x;
   *new_y = cascade_y;
@@ -359,97 +627,6 @@ avoid_being_obscured_as_second_modal_dialog (CobiwmWindow *window,
     }
 }
 
-static gboolean
-rectangle_overlaps_some_window (CobiwmRectangle *rect,
-                                GList         *windows)
-{
-  GList *tmp;
-  CobiwmRectangle dest;
-
-  tmp = windows;
-  while (tmp != NULL)
-    {
-      CobiwmWindow *other = tmp->data;
-      CobiwmRectangle other_rect;
-
-      switch (other->type)
-        {
-        case COBIWM_WINDOW_DOCK:
-        case COBIWM_WINDOW_SPLASHSCREEN:
-        case COBIWM_WINDOW_DESKTOP:
-        case COBIWM_WINDOW_DIALOG:
-        case COBIWM_WINDOW_MODAL_DIALOG:
-	/* override redirect window types: */
-	case COBIWM_WINDOW_DROPDOWN_MENU:
-	case COBIWM_WINDOW_POPUP_MENU:
-	case COBIWM_WINDOW_TOOLTIP:
-	case COBIWM_WINDOW_NOTIFICATION:
-	case COBIWM_WINDOW_COMBO:
-	case COBIWM_WINDOW_DND:
-	case COBIWM_WINDOW_OVERRIDE_OTHER:
-          break;
-
-        case COBIWM_WINDOW_NORMAL:
-        case COBIWM_WINDOW_UTILITY:
-        case COBIWM_WINDOW_TOOLBAR:
-        case COBIWM_WINDOW_MENU:
-          cobiwm_window_get_frame_rect (other, &other_rect);
-
-          if (cobiwm_rectangle_intersect (rect, &other_rect, &dest))
-            return TRUE;
-          break;
-        }
-
-      tmp = tmp->next;
-    }
-
-  return FALSE;
-}
-
-static gint
-leftmost_cmp (gconstpointer a, gconstpointer b)
-{
-  CobiwmWindow *aw = (gpointer) a;
-  CobiwmWindow *bw = (gpointer) b;
-  CobiwmRectangle a_frame;
-  CobiwmRectangle b_frame;
-  int ax, bx;
-
-  cobiwm_window_get_frame_rect (aw, &a_frame);
-  cobiwm_window_get_frame_rect (bw, &b_frame);
-  ax = a_frame.x;
-  bx = b_frame.x;
-
-  if (ax < bx)
-    return -1;
-  else if (ax > bx)
-    return 1;
-  else
-    return 0;
-}
-
-static gint
-topmost_cmp (gconstpointer a, gconstpointer b)
-{
-  CobiwmWindow *aw = (gpointer) a;
-  CobiwmWindow *bw = (gpointer) b;
-  CobiwmRectangle a_frame;
-  CobiwmRectangle b_frame;
-  int ay, by;
-
-  cobiwm_window_get_frame_rect (aw, &a_frame);
-  cobiwm_window_get_frame_rect (bw, &b_frame);
-  ay = a_frame.y;
-  by = b_frame.y;
-
-  if (ay < by)
-    return -1;
-  else if (ay > by)
-    return 1;
-  else
-    return 0;
-}
-
 static void
 center_tile_rect_in_area (CobiwmRectangle *rect,
                           CobiwmRectangle *work_area)
@@ -479,7 +656,7 @@ center_tile_rect_in_area (CobiwmRectangle *rect,
 static gboolean
 find_first_fit (CobiwmWindow *window,
                 /* visible windows on relevant workspaces */
-                GList      *windows,
+                PlacementIndex *index,
 		int         monitor,
                 int         x,
                 int         y,
@@ -494,23 +671,15 @@ find_first_fit (CobiwmWindow *window,
    * existing window in each of those cases.
    */
   int retval;
-  GList *below_sorted;
-  GList *right_sorted;
-  GList *tmp;
+  guint *below_sorted;
+  guint *right_sorted;
+  guint i;
   CobiwmRectangle rect;
   CobiwmRectangle work_area;
 
   retval = FALSE;
-
-  /* Below each window */
-  below_sorted = g_list_copy (windows);
-  below_sorted = g_list_sort (below_sorted, leftmost_cmp);
-  below_sorted = g_list_sort (below_sorted, topmost_cmp);
-
-  /* To the right of each window */
-  right_sorted = g_list_copy (windows);
-  right_sorted = g_list_sort (right_sorted, topmost_cmp);
-  right_sorted = g_list_sort (right_sorted, leftmost_cmp);
+  below_sorted = NULL;
+  right_sorted = NULL;
 
   cobiwm_window_get_frame_rect (window, &rect);
 
@@ -530,7 +699,7 @@ find_first_fit (CobiwmWindow *window,
   center_tile_rect_in_area (&rect, &work_area);
 
   if (cobiwm_rectangle_contains_rect (&work_area, &rect) &&
-      !rectangle_overlaps_some_window (&rect, windows))
+      !placement_index_overlaps (index, &rect))
     {
       *new_x = rect.x;
       *new_y = rect.y;
@@ -541,19 +710,16 @@ find_first_fit (CobiwmWindow *window,
     }
 
   /* try below each window */
-  tmp = below_sorted;
-  while (tmp != NULL)
+  below_sorted = placement_index_sort (index, below_cmp);
+  for (i = 0; i < index->n_entries; i++)
     {
-      CobiwmWindow *w = tmp->data;
-      CobiwmRectangle frame_rect;
+      PlacementEntry *entry = &index->entries[below_sorted[i]];
 
-      cobiwm_window_get_frame_rect (w, &frame_rect);
-
-      rect.x = frame_rect.x;
-      rect.y = frame_rect.y + frame_rect.height;
+      rect.x = entry->rect.x;
+      rect.y = entry->rect.y + entry->rect.height;
 
       if (cobiwm_rectangle_contains_rect (&work_area, &rect) &&
-          !rectangle_overlaps_some_window (&rect, below_sorted))
+          !placement_index_overlaps (index, &rect))
         {
           *new_x = rect.x;
           *new_y = rect.y;
@@ -562,24 +728,19 @@ find_first_fit (CobiwmWindow *window,
 
           goto out;
         }
-
-      tmp = tmp->next;
     }
 
   /* try to the right of each window */
-  tmp = right_sorted;
-  while (tmp != NULL)
+  right_sorted = placement_index_sort (index, right_cmp);
+  for (i = 0; i < index->n_entries; i++)
     {
-      CobiwmWindow *w = tmp->data;
-      CobiwmRectangle frame_rect;
-
-      cobiwm_window_get_frame_rect (w, &frame_rect);
+      PlacementEntry *entry = &index->entries[right_sorted[i]];
 
-      rect.x = frame_rect.x + frame_rect.width;
-      rect.y = frame_rect.y;
+      rect.x = entry->rect.x + entry->rect.width;
+      rect.y = entry->rect.y;
 
       if (cobiwm_rectangle_contains_rect (&work_area, &rect) &&
-          !rectangle_overlaps_some_window (&rect, right_sorted))
+          !placement_index_overlaps (index, &rect))
         {
           *new_x = rect.x;
           *new_y = rect.y;
@@ -588,13 +749,11 @@ find_first_fit (CobiwmWindow *window,
 
           goto out;
         }
-
-      tmp = tmp->next;
     }
 
  out:
-  g_list_free (below_sorted);
-  g_list_free (right_sorted);
+  g_free (below_sorted);
+  g_free (right_sorted);
   return retval;
 }
 
@@ -606,6 +765,7 @@ cobiwm_window_place (CobiwmWindow        *window,
                    int               *new_y)
 {
   GList *windows = NULL;
+  PlacementIndex index = { NULL, };
   const CobiwmMonitorInfo *xi;
 
   cobiwm_topic (COBIWM_DEBUG_PLACEMENT, "Placing window %s\n", window->desc);
@@ -789,6 +949,8 @@ cobiwm_window_place (CobiwmWindow        *window,
     g_slist_free (all_windows);
   }
 
+  placement_index_init (&index, windows);
+
   /* Warning, this is a round trip! */
   xi = cobiwm_screen_get_current_monitor_info (window->screen);
 
@@ -821,13 +983,13 @@ cobiwm_window_place (CobiwmWindow        *window,
   x = xi->rect.x;
   y = xi->rect.y;
 
-  if (find_first_fit (window, windows,
+  if (find_first_fit (window, &index,
                       xi->number,
                       x, y, &x, &y))
     goto done_check_denied_focus;
 
   /* No good fit? Fall back to cascading... */
-  find_next_cascade (window, windows, x, y, &x, &y);
+  find_next_cascade (window, &index, x, y, &x, &y);
 
  done_check_denied_focus:
   /* If the window is being denied focus and isn't a transient of the
@@ -852,15 +1014,19 @@ cobiwm_window_place (CobiwmWindow        *window,
       if (!found_fit)
         {
           GList *focus_window_list;
+          PlacementIndex focus_index;
+
           focus_window_list = g_list_prepend (NULL, focus_window);
+          placement_index_init (&focus_index, focus_window_list);
 
           /* Reset x and y ("origin" placement algorithm) */
           x = xi->rect.x;
           y = xi->rect.y;
 
-          found_fit = find_first_fit (window, focus_window_list,
+          found_fit = find_first_fit (window, &focus_index,
                                       xi->number,
                                       x, y, &x, &y);
+          placement_index_clear (&focus_index);
           g_list_free (focus_window_list);
 	}
 
@@ -872,6 +1038,7 @@ cobiwm_window_place (CobiwmWindow        *window,
     }
 
  done:
+  placement_index_clear (&index);
   if (windows)
     g_list_free (windows);
 
@@ -71,7 +71,10 @@
 
 #define SETTINGS(s) g_hash_table_lookup (settings_schemas, (s))
 
-static GList *changes = NULL;
+/* Preferences whose listeners have yet to be notified, one bit per
+ * CobiwmPreference
+ */
+static guint64 pending_changes = 0;
 static guint changed_idle;
 static GList *listeners = NULL;
 static GHashTable *settings_schemas;
@@ -884,31 +887,33 @@ emit_changed (CobiwmPreference pref)
   g_list_free (copy);
 }
 
+#define PREF_BIT(pref) (G_GUINT64_CONSTANT (1) << (pref))
+
+G_STATIC_ASSERT (COBIWM_PREF_LAST <= 64);
+
 static gboolean
 changed_idle_handler (gpointer data)
 {
-  GList *tmp;
-  GList *copy;
+  guint64 changes;
+  CobiwmPreference pref;
 
   changed_idle = 0;
 
-  copy = g_list_copy (changes); /* reentrancy paranoia */
-
-  g_list_free (changes);
-  changes = NULL;
+  /* Listeners may change preferences themselves, which queues a new
+   * batch rather than touching this one.
+   */
+  changes = pending_changes;
+  pending_changes = 0;
 
-  tmp = copy;
-  while (tmp != NULL)
+  for (pref = 0; changes != 0; pref++)
     {
-      CobiwmPreference pref = GPOINTER_TO_INT (tmp->data);
-
-      emit_changed (pref);
-
-      tmp = tmp->next;
+      if (changes & PREF_BIT (pref))
+        {
+          changes &= ~PREF_BIT (pref);
+          emit_changed (pref);
+        }
     }
 
-  g_list_free (copy);
-
   return FALSE;
 }
 
@@ -918,12 +923,12 @@ queue_changed (CobiwmPreference pref)
   cobiwm_topic (COBIWM_DEBUG_PREFS, "Queueing change of pref %s\n",
               cobiwm_preference_to_string (pref));
 
-  if (g_list_find (changes, GINT_TO_POINTER (pref)) == NULL)
-    changes = g_list_prepend (changes, GINT_TO_POINTER (pref));
-  else
+  if (pending_changes & PREF_BIT (pref))
     cobiwm_topic (COBIWM_DEBUG_PREFS, "Change of pref %s was already pending\n",
                 cobiwm_preference_to_string (pref));
 
+  pending_changes |= PREF_BIT (pref);
+
   if (changed_idle == 0)
     {
       changed_idle = g_idle_add_full (COBIWM_PRIORITY_PREFS_NOTIFY,
@@ -1850,6 +1855,9 @@ cobiwm_preference_to_string (CobiwmPreference pref)
 
     case COBIWM_PREF_AUTO_MAXIMIZE:
       return "AUTO_MAXIMIZE";
+
+    case COBIWM_PREF_LAST:
+      break;
     }
 
   return "(unknown)";
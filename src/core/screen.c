@@ -826,22 +826,22 @@ void
 cobiwm_screen_manage_all_windows (CobiwmScreen *screen)
 {
   guint64 *_children;
-  guint64 *children;
+  Window *children;
   int n_children, i;
 
   cobiwm_stack_freeze (screen->stack);
   cobiwm_stack_tracker_get_stack (screen->stack_tracker, &_children, &n_children);
 
   /* Copy the stack as it will be modified as part of the loop */
-  children = g_memdup (_children, sizeof (guint64) * n_children);
-
+  children = g_new (Window, n_children);
   for (i = 0; i < n_children; ++i)
     {
-      g_assert (COBIWM_STACK_ID_IS_X11 (children[i]));
-      cobiwm_window_x11_new (screen->display, children[i], TRUE,
-                           COBIWM_COMP_EFFECT_NONE);
+      g_assert (COBIWM_STACK_ID_IS_X11 (_children[i]));
+      children[i] = _children[i];
     }
 
+  cobiwm_window_x11_adopt_windows (screen->display, children, n_children);
+
   g_free (children);
   cobiwm_stack_thaw (screen->stack);
 }
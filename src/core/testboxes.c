@@ -23,6 +23,7 @@
 #include <glib.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <X11/Xutil.h> /* Just for the definition of the various gravities */
 #include <time.h>      /* To initialize random seed */
 #include <math.h>
@@ -1380,9 +1381,240 @@ test_find_closest_point_to_line (void)
   printf ("%s passed.\n", G_STRFUNC);
 }
 
+/* Benchmark mode: "testboxes --benchmark [iterations]" times the region
+ * and edge code on synthetic layouts with many monitors and struts, to
+ * get numbers to compare against when optimizing boxes.c.
+ */
+#define BENCHMARK_DEFAULT_ITERATIONS 2000
+#define BENCHMARK_MONITOR_WIDTH      1920
+#define BENCHMARK_MONITOR_HEIGHT     1080
+
+static GList*
+get_benchmark_monitors (int n_monitors)
+{
+  GList *ret = NULL;
+  int i;
+
+  for (i = n_monitors - 1; i >= 0; i--)
+    ret = g_list_prepend (ret,
+                          new_cobiwm_rect (i * BENCHMARK_MONITOR_WIDTH, 0,
+                                           BENCHMARK_MONITOR_WIDTH,
+                                           BENCHMARK_MONITOR_HEIGHT));
+
+  return ret;
+}
+
+/* Every monitor gets a full width top panel, and then alternately partial
+ * bottom, left and right docks until it has struts_per_monitor struts.
+ */
+static GSList*
+get_benchmark_struts (int n_monitors, int struts_per_monitor)
+{
+  GSList *ret = NULL;
+  int i, j;
+
+  for (i = 0; i < n_monitors; i++)
+    {
+      int x = i * BENCHMARK_MONITOR_WIDTH;
+
+      ret = g_slist_prepend (ret,
+                             new_cobiwm_strut (x, 0,
+                                               BENCHMARK_MONITOR_WIDTH, 24,
+                                               COBIWM_SIDE_TOP));
+
+      for (j = 1; j < struts_per_monitor; j++)
+        {
+          int offset = 40 * j;
+
+          switch (j % 3)
+            {
+            case 1:
+              ret = g_slist_prepend (ret,
+                                     new_cobiwm_strut (x + 100 + offset,
+                                                       BENCHMARK_MONITOR_HEIGHT - 48,
+                                                       600, 48,
+                                                       COBIWM_SIDE_BOTTOM));
+              break;
+            case 2:
+              ret = g_slist_prepend (ret,
+                                     new_cobiwm_strut (x, 100 + offset,
+                                                       64, 400,
+                                                       COBIWM_SIDE_LEFT));
+              break;
+            default:
+              ret = g_slist_prepend (ret,
+                                     new_cobiwm_strut (x + BENCHMARK_MONITOR_WIDTH - 64,
+                                                       100 + offset,
+                                                       64, 400,
+                                                       COBIWM_SIDE_RIGHT));
+              break;
+            }
+        }
+    }
+
+  return ret;
+}
+
+static void
+report_benchmark (const char *what,
+                  gint64      start,
+                  int         calls)
+{
+  gint64 elapsed = g_get_monotonic_time () - start;
+
+  printf ("  %-44s %10.3f us/call\n", what, (double) elapsed / calls);
+}
+
+static void
+benchmark_layout (int n_monitors,
+                  int struts_per_monitor,
+                  int iterations)
+{
+  CobiwmRectangle  screen_rect, min_size;
+  CobiwmRectangle *rects;
+  GList          *monitors, *l;
+  GSList         *struts;
+  GArray         *region;
+  gint64          start;
+  int             i;
+
+  screen_rect = cobiwm_rect (0, 0,
+                             n_monitors * BENCHMARK_MONITOR_WIDTH,
+                             BENCHMARK_MONITOR_HEIGHT);
+  min_size = cobiwm_rect (0, 0, 100, 100);
+  monitors = get_benchmark_monitors (n_monitors);
+  struts = get_benchmark_struts (n_monitors, struts_per_monitor);
+
+  /* Same sequence of rectangles for each run */
+  srand (n_monitors * 100 + struts_per_monitor);
+  rects = g_new (CobiwmRectangle, iterations);
+  for (i = 0; i < iterations; i++)
+    {
+      rects[i].x = rand () % screen_rect.width - 200;
+      rects[i].y = rand () % screen_rect.height - 200;
+      rects[i].width  = rand () % 1600 + 1;
+      rects[i].height = rand () % 1000 + 1;
+    }
+
+  printf ("%d monitors, %d struts:\n",
+          n_monitors, g_slist_length (struts));
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++)
+    cobiwm_rectangle_free_list_and_elements (
+      cobiwm_rectangle_get_minimal_spanning_set_for_region (&screen_rect,
+                                                            struts));
+  report_benchmark ("get_minimal_spanning_set_for_region", start, iterations);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++)
+    g_array_free (
+      cobiwm_rectangle_get_minimal_spanning_array_for_region (&screen_rect,
+                                                              struts),
+      TRUE);
+  report_benchmark ("get_minimal_spanning_array_for_region", start,
+                    iterations);
+
+  /* What workspace.c does whenever the work areas are invalidated */
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++)
+    {
+      g_array_free (
+        cobiwm_rectangle_get_minimal_spanning_array_for_region (&screen_rect,
+                                                                struts),
+        TRUE);
+      for (l = monitors; l; l = l->next)
+        g_array_free (
+          cobiwm_rectangle_get_minimal_spanning_array_for_region (l->data,
+                                                                  struts),
+          TRUE);
+    }
+  report_benchmark ("work area recomputation", start, iterations);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++)
+    cobiwm_rectangle_free_list_and_elements (
+      cobiwm_rectangle_find_onscreen_edges (&screen_rect, struts));
+  report_benchmark ("find_onscreen_edges", start, iterations);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++)
+    cobiwm_rectangle_free_list_and_elements (
+      cobiwm_rectangle_find_nonintersected_monitor_edges (monitors, struts));
+  report_benchmark ("find_nonintersected_monitor_edges", start, iterations);
+
+  region = cobiwm_rectangle_get_minimal_spanning_array_for_region (&screen_rect,
+                                                                   struts);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++)
+    {
+      cobiwm_rectangle_could_fit_in_region_array (region, &rects[i]);
+      cobiwm_rectangle_contained_in_region_array (region, &rects[i]);
+    }
+  report_benchmark ("could_fit_in/contained_in_region", start, iterations);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++)
+    {
+      CobiwmRectangle rect = rects[i];
+      cobiwm_rectangle_clamp_to_fit_into_region_array (region,
+                                                       FIXED_DIRECTION_NONE,
+                                                       &rect,
+                                                       &min_size);
+    }
+  report_benchmark ("clamp_to_fit_into_region", start, iterations);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++)
+    {
+      CobiwmRectangle rect = rects[i];
+      cobiwm_rectangle_clip_to_region_array (region, FIXED_DIRECTION_NONE,
+                                             &rect);
+    }
+  report_benchmark ("clip_to_region", start, iterations);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++)
+    {
+      CobiwmRectangle rect = rects[i];
+      cobiwm_rectangle_shove_into_region_array (region, FIXED_DIRECTION_NONE,
+                                                &rect);
+    }
+  report_benchmark ("shove_into_region", start, iterations);
+
+  g_array_free (region, TRUE);
+  g_free (rects);
+  free_strut_list (struts);
+  cobiwm_rectangle_free_list_and_elements (monitors);
+}
+
+static void
+run_benchmarks (int iterations)
+{
+  static const int monitor_counts[] = { 1, 2, 4, 8 };
+  static const int strut_counts[]   = { 1, 4, 8 };
+  guint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (monitor_counts); i++)
+    for (j = 0; j < G_N_ELEMENTS (strut_counts); j++)
+      benchmark_layout (monitor_counts[i], strut_counts[j], iterations);
+}
+
 int
-main(void)
+main (int argc, char **argv)
 {
+  if (argc > 1 && strcmp (argv[1], "--benchmark") == 0)
+    {
+      int iterations = BENCHMARK_DEFAULT_ITERATIONS;
+
+      if (argc > 2)
+        iterations = MAX (atoi (argv[2]), 1);
+
+      run_benchmarks (iterations);
+      return 0;
+    }
+
   init_random_ness ();
   test_area ();
   test_intersect ();
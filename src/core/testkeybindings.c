@@ -0,0 +1,371 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+
+/* Cobiwm key binding index testing program */
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include "keybindings-index.h"
+#include <glib.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NUM_RANDOM_RUNS 200000
+
+/* The index never looks at the bindings, so any non-NULL pointer does */
+#define FAKE_BINDING(n) ((CobiwmKeyBinding *) GUINT_TO_POINTER ((n) + 1))
+
+/* Same layout as key_combo_key() in keybindings.c */
+static guint32
+combo_key (guint keycode,
+           guint mask)
+{
+  return ((keycode & 0xffff) << 16) | (mask & 0xffff);
+}
+
+static guint32
+random_combo_key (GRand *rand)
+{
+  return combo_key (g_rand_int_range (rand, 8, 256),
+                    g_rand_int_range (rand, 0, 256));
+}
+
+/* Every binding in @index is where a lookup finds it, and nothing else */
+static void
+check_index_matches (CobiwmKeyBindingIndex *index,
+                     GHashTable          *reference)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+  guint i, n_used;
+
+  g_assert_cmpuint (index->count, ==, g_hash_table_size (reference));
+  g_assert_cmpuint (index->count * 2, <=, index->size);
+
+  g_hash_table_iter_init (&iter, reference);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    g_assert (cobiwm_key_binding_index_lookup (index, GPOINTER_TO_UINT (key)) == value);
+
+  n_used = 0;
+  for (i = 0; i < index->size; i++)
+    if (index->slots[i].binding != NULL)
+      {
+        g_assert (g_hash_table_lookup (reference,
+                                       GUINT_TO_POINTER (index->slots[i].key)) ==
+                  index->slots[i].binding);
+        n_used++;
+      }
+  g_assert_cmpuint (n_used, ==, index->count);
+}
+
+static void
+test_insert_lookup_remove (void)
+{
+  CobiwmKeyBindingIndex index;
+  guint i;
+
+  cobiwm_key_binding_index_init (&index);
+
+  g_assert (cobiwm_key_binding_index_lookup (&index, combo_key (38, 0)) == NULL);
+
+  cobiwm_key_binding_index_insert (&index, combo_key (38, 0), FAKE_BINDING (1));
+  cobiwm_key_binding_index_insert (&index, combo_key (38, 4), FAKE_BINDING (2));
+  g_assert_cmpuint (index.count, ==, 2);
+  g_assert (cobiwm_key_binding_index_lookup (&index, combo_key (38, 0)) == FAKE_BINDING (1));
+  g_assert (cobiwm_key_binding_index_lookup (&index, combo_key (38, 4)) == FAKE_BINDING (2));
+  g_assert (cobiwm_key_binding_index_lookup (&index, combo_key (38, 8)) == NULL);
+
+  /* Inserting an existing key replaces its binding */
+  cobiwm_key_binding_index_insert (&index, combo_key (38, 0), FAKE_BINDING (3));
+  g_assert_cmpuint (index.count, ==, 2);
+  g_assert (cobiwm_key_binding_index_lookup (&index, combo_key (38, 0)) == FAKE_BINDING (3));
+
+  cobiwm_key_binding_index_remove (&index, combo_key (38, 0));
+  g_assert_cmpuint (index.count, ==, 1);
+  g_assert (cobiwm_key_binding_index_lookup (&index, combo_key (38, 0)) == NULL);
+  g_assert (cobiwm_key_binding_index_lookup (&index, combo_key (38, 4)) == FAKE_BINDING (2));
+
+  /* Removing a missing key does nothing */
+  cobiwm_key_binding_index_remove (&index, combo_key (38, 0));
+  g_assert_cmpuint (index.count, ==, 1);
+
+  /* Growing keeps everything findable */
+  for (i = 0; i < 1000; i++)
+    cobiwm_key_binding_index_insert (&index, combo_key (8 + i / 64, i % 64),
+                                   FAKE_BINDING (i));
+  g_assert_cmpuint (index.size, >=, 2000);
+  for (i = 0; i < 1000; i++)
+    g_assert (cobiwm_key_binding_index_lookup (&index, combo_key (8 + i / 64, i % 64)) ==
+              FAKE_BINDING (i));
+
+  cobiwm_key_binding_index_clear (&index);
+  g_assert_cmpuint (index.count, ==, 0);
+  for (i = 0; i < 1000; i++)
+    g_assert (cobiwm_key_binding_index_lookup (&index, combo_key (8 + i / 64, i % 64)) ==
+              NULL);
+
+  cobiwm_key_binding_index_destroy (&index);
+
+  printf ("%s passed.\n", G_STRFUNC);
+}
+
+/* Finds @n_keys keys whose probe sequences start at @home */
+static void
+find_keys_with_home (CobiwmKeyBindingIndex *index,
+                     guint                home,
+                     guint32             *keys,
+                     guint                n_keys)
+{
+  guint32 key;
+  guint found = 0;
+
+  for (key = 1; found < n_keys; key++)
+    if (cobiwm_key_binding_index_home (index, key) == home)
+      keys[found++] = key;
+}
+
+static void
+test_probe_wrap_around (void)
+{
+  CobiwmKeyBindingIndex index;
+  guint32 last_keys[3], first_keys[2];
+  guint last;
+
+  cobiwm_key_binding_index_init (&index);
+  last = index.size - 1;
+
+  find_keys_with_home (&index, last, last_keys, 3);
+  find_keys_with_home (&index, 0, first_keys, 2);
+
+  /* The last slot's keys wrap around to slots 0 and 1, pushing the
+   * keys that belong in slot 0 to slots 2 and 3.
+   */
+  cobiwm_key_binding_index_insert (&index, last_keys[0], FAKE_BINDING (0));
+  cobiwm_key_binding_index_insert (&index, last_keys[1], FAKE_BINDING (1));
+  cobiwm_key_binding_index_insert (&index, last_keys[2], FAKE_BINDING (2));
+  cobiwm_key_binding_index_insert (&index, first_keys[0], FAKE_BINDING (3));
+  cobiwm_key_binding_index_insert (&index, first_keys[1], FAKE_BINDING (4));
+
+  g_assert (index.slots[last].key == last_keys[0]);
+  g_assert (index.slots[0].key == last_keys[1]);
+  g_assert (index.slots[1].key == last_keys[2]);
+  g_assert (index.slots[2].key == first_keys[0]);
+  g_assert (index.slots[3].key == first_keys[1]);
+
+  /* Removing at the end of the table shifts back across the wrap */
+  cobiwm_key_binding_index_remove (&index, last_keys[0]);
+  g_assert (index.slots[last].key == last_keys[1]);
+  g_assert (index.slots[0].key == last_keys[2]);
+  g_assert (index.slots[1].key == first_keys[0]);
+  g_assert (index.slots[2].key == first_keys[1]);
+  g_assert (index.slots[3].binding == NULL);
+
+  g_assert (cobiwm_key_binding_index_lookup (&index, last_keys[0]) == NULL);
+  g_assert (cobiwm_key_binding_index_lookup (&index, last_keys[1]) == FAKE_BINDING (1));
+  g_assert (cobiwm_key_binding_index_lookup (&index, last_keys[2]) == FAKE_BINDING (2));
+  g_assert (cobiwm_key_binding_index_lookup (&index, first_keys[0]) == FAKE_BINDING (3));
+  g_assert (cobiwm_key_binding_index_lookup (&index, first_keys[1]) == FAKE_BINDING (4));
+
+  /* Again, now with the shifted keys back in or next to their home */
+  cobiwm_key_binding_index_remove (&index, last_keys[1]);
+  g_assert (index.slots[last].key == last_keys[2]);
+  g_assert (index.slots[0].key == first_keys[0]);
+  g_assert (index.slots[1].key == first_keys[1]);
+  g_assert (index.slots[2].binding == NULL);
+
+  cobiwm_key_binding_index_remove (&index, first_keys[0]);
+  g_assert (index.slots[0].key == first_keys[1]);
+  g_assert (cobiwm_key_binding_index_lookup (&index, last_keys[2]) == FAKE_BINDING (2));
+  g_assert (cobiwm_key_binding_index_lookup (&index, first_keys[1]) == FAKE_BINDING (4));
+  g_assert_cmpuint (index.count, ==, 2);
+
+  cobiwm_key_binding_index_destroy (&index);
+
+  printf ("%s passed.\n", G_STRFUNC);
+}
+
+/* Random inserts and removes, checked against a GHashTable */
+static void
+test_random_operations (void)
+{
+  CobiwmKeyBindingIndex index;
+  GHashTable *reference;
+  GRand *rand;
+  int i;
+
+  rand = g_rand_new_with_seed (0xc0b1);
+  reference = g_hash_table_new (NULL, NULL);
+  cobiwm_key_binding_index_init (&index);
+
+  for (i = 0; i < NUM_RANDOM_RUNS; i++)
+    {
+      /* Few distinct keys, so removes usually hit and chains get long */
+      guint32 key = combo_key (g_rand_int_range (rand, 8, 24),
+                               g_rand_int_range (rand, 0, 16));
+
+      if (g_rand_boolean (rand))
+        {
+          cobiwm_key_binding_index_insert (&index, key, FAKE_BINDING (i));
+          g_hash_table_insert (reference, GUINT_TO_POINTER (key), FAKE_BINDING (i));
+        }
+      else
+        {
+          cobiwm_key_binding_index_remove (&index, key);
+          g_hash_table_remove (reference, GUINT_TO_POINTER (key));
+        }
+
+      if (i % 97 == 0)
+        check_index_matches (&index, reference);
+    }
+
+  check_index_matches (&index, reference);
+
+  cobiwm_key_binding_index_destroy (&index);
+  g_hash_table_destroy (reference);
+  g_rand_free (rand);
+
+  printf ("%s passed.\n", G_STRFUNC);
+}
+
+/* Benchmark mode: "testkeybindings --benchmark [iterations]" times
+ * lookups in the index against the GHashTable it replaced, with the
+ * number of bindings of a typical setup and more.
+ */
+#define BENCHMARK_DEFAULT_ITERATIONS 2000000
+
+static void
+report_benchmark (const char *what,
+                  gint64      start,
+                  int         calls)
+{
+  gint64 elapsed = g_get_monotonic_time () - start;
+
+  printf ("  %-44s %10.3f ns/call\n", what, (double) elapsed * 1000 / calls);
+}
+
+static void
+benchmark_bindings (int n_bindings,
+                    int iterations)
+{
+  CobiwmKeyBindingIndex index;
+  GHashTable *table;
+  guint32 *lookups;
+  GRand *rand;
+  gint64 start;
+  gpointer found;
+  int i;
+
+  rand = g_rand_new_with_seed (n_bindings);
+  table = g_hash_table_new (NULL, NULL);
+  cobiwm_key_binding_index_init (&index);
+
+  for (i = 0; i < n_bindings; i++)
+    {
+      guint32 key = random_combo_key (rand);
+
+      cobiwm_key_binding_index_insert (&index, key, FAKE_BINDING (i));
+      g_hash_table_insert (table, GUINT_TO_POINTER (key), FAKE_BINDING (i));
+    }
+
+  /* Most key presses are typing, which isn't bound */
+  lookups = g_new (guint32, iterations);
+  for (i = 0; i < iterations; i++)
+    lookups[i] = random_combo_key (rand);
+
+  printf ("%d bindings:\n", n_bindings);
+
+  found = NULL;
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++)
+    found = (gpointer) ((gsize) found ^
+                        (gsize) g_hash_table_lookup (table,
+                                                     GUINT_TO_POINTER (lookups[i])));
+  report_benchmark ("g_hash_table_lookup", start, iterations);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++)
+    found = (gpointer) ((gsize) found ^
+                        (gsize) cobiwm_key_binding_index_lookup (&index, lookups[i]));
+  report_benchmark ("cobiwm_key_binding_index_lookup", start, iterations);
+
+  /* What reload_combos() does on keymap and binding changes */
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations / n_bindings; i++)
+    {
+      int j;
+
+      cobiwm_key_binding_index_clear (&index);
+      for (j = 0; j < n_bindings; j++)
+        cobiwm_key_binding_index_insert (&index, lookups[j], FAKE_BINDING (j));
+    }
+  report_benchmark ("cobiwm_key_binding_index_insert", start,
+                    MAX (iterations / n_bindings, 1) * n_bindings);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations / n_bindings; i++)
+    {
+      int j;
+
+      for (j = 0; j < n_bindings; j++)
+        cobiwm_key_binding_index_remove (&index, lookups[j]);
+      for (j = 0; j < n_bindings; j++)
+        cobiwm_key_binding_index_insert (&index, lookups[j], FAKE_BINDING (j));
+    }
+  report_benchmark ("cobiwm_key_binding_index_remove + insert", start,
+                    MAX (iterations / n_bindings, 1) * n_bindings);
+
+  /* Keep the lookups from being optimized out */
+  if (found == FAKE_BINDING (G_MAXUINT - 1))
+    printf ("\n");
+
+  g_free (lookups);
+  cobiwm_key_binding_index_destroy (&index);
+  g_hash_table_destroy (table);
+  g_rand_free (rand);
+}
+
+static void
+run_benchmarks (int iterations)
+{
+  static const int binding_counts[] = { 16, 128, 512 };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (binding_counts); i++)
+    benchmark_bindings (binding_counts[i], MAX (iterations, binding_counts[i]));
+}
+
+int
+main (int argc, char **argv)
+{
+  if (argc > 1 && strcmp (argv[1], "--benchmark") == 0)
+    {
+      int iterations = BENCHMARK_DEFAULT_ITERATIONS;
+
+      if (argc > 2)
+        iterations = MAX (atoi (argv[2]), 1);
+
+      run_benchmarks (iterations);
+      return 0;
+    }
+
+  test_insert_lookup_remove ();
+  test_probe_wrap_around ();
+  test_random_operations ();
+
+  printf ("All tests passed.\n");
+  return 0;
+}
@@ -4767,6 +4767,10 @@ cobiwm_window_set_focused_internal (CobiwmWindow *window,
       /* move into FOCUSED_WINDOW layer */
       cobiwm_window_update_layer (window);
 
+      /* With lazy grabs only the focus window holds its key grabs */
+      if (window->display->key_binding_manager.lazy_window_grabs)
+        cobiwm_window_grab_keys (window);
+
       /* Ungrab click to focus button since the sync grab can interfere
        * with some things you might do inside the focused window, by
        * causing the client to get funky enter/leave events.
@@ -4805,6 +4809,9 @@ cobiwm_window_set_focused_internal (CobiwmWindow *window,
       /* move out of FOCUSED_WINDOW layer */
       cobiwm_window_update_layer (window);
 
+      if (window->display->key_binding_manager.lazy_window_grabs)
+        cobiwm_window_grab_keys (window);
+
       /* Re-grab for click to focus and raise-on-click, if necessary */
       if (cobiwm_prefs_get_focus_mode () == G_DESKTOP_FOCUS_MODE_CLICK ||
           !cobiwm_prefs_get_raise_on_click ())
@@ -5356,7 +5363,7 @@ void
 cobiwm_window_shove_titlebar_onscreen (CobiwmWindow *window)
 {
   CobiwmRectangle  frame_rect;
-  GList         *onscreen_region;
+  GArray        *onscreen_region;
   int            horiz_amount, vert_amount;
 
   g_return_if_fail (!window->override_redirect);
@@ -5375,19 +5382,23 @@ cobiwm_window_shove_titlebar_onscreen (CobiwmWindow *window)
    */
   horiz_amount = frame_rect.width;
   vert_amount  = frame_rect.height;
-  cobiwm_rectangle_expand_region (onscreen_region,
-                                horiz_amount,
-                                horiz_amount,
-                                0,
-                                vert_amount);
-  cobiwm_rectangle_shove_into_region(onscreen_region,
-                                   FIXED_DIRECTION_X,
-                                   &frame_rect);
-  cobiwm_rectangle_expand_region (onscreen_region,
-                                -horiz_amount,
-                                -horiz_amount,
-                                0,
-                                -vert_amount);
+  cobiwm_rectangle_expand_region_array_conditionally (onscreen_region,
+                                                    horiz_amount,
+                                                    horiz_amount,
+                                                    0,
+                                                    vert_amount,
+                                                    0,
+                                                    0);
+  cobiwm_rectangle_shove_into_region_array (onscreen_region,
+                                          FIXED_DIRECTION_X,
+                                          &frame_rect);
+  cobiwm_rectangle_expand_region_array_conditionally (onscreen_region,
+                                                    -horiz_amount,
+                                                    -horiz_amount,
+                                                    0,
+                                                    -vert_amount,
+                                                    0,
+                                                    0);
 
   cobiwm_window_move_frame (window, FALSE, frame_rect.x, frame_rect.y);
 }
@@ -5396,8 +5407,9 @@ gboolean
 cobiwm_window_titlebar_is_onscreen (CobiwmWindow *window)
 {
   CobiwmRectangle  titlebar_rect, frame_rect;
-  GList         *onscreen_region;
+  GArray        *onscreen_region;
   gboolean       is_onscreen;
+  guint          i;
 
   const int min_height_needed  = 8;
   const float min_width_percent  = 0.5;
@@ -5420,9 +5432,10 @@ cobiwm_window_titlebar_is_onscreen (CobiwmWindow *window)
    */
   is_onscreen = FALSE;
   onscreen_region = window->screen->active_workspace->screen_region;
-  while (onscreen_region)
+  for (i = 0; onscreen_region && i < onscreen_region->len; i++)
     {
-      CobiwmRectangle *spanning_rect = onscreen_region->data;
+      CobiwmRectangle *spanning_rect =
+        &g_array_index (onscreen_region, CobiwmRectangle, i);
       CobiwmRectangle overlap;
 
       cobiwm_rectangle_intersect (&titlebar_rect, spanning_rect, &overlap);
@@ -5433,8 +5446,6 @@ cobiwm_window_titlebar_is_onscreen (CobiwmWindow *window)
           is_onscreen = TRUE;
           break;
         }
-
-      onscreen_region = onscreen_region->next;
     }
 
   return is_onscreen;
@@ -5896,6 +5907,74 @@ cobiwm_window_update_resize (CobiwmWindow *window,
   update_resize (window, snap, x, y, force);
 }
 
+static void
+apply_grab_motion (CobiwmWindow *window,
+                   gboolean    snap,
+                   int         x,
+                   int         y)
+{
+  if (cobiwm_grab_op_is_moving (window->display->grab_op))
+    update_move (window, snap, x, y);
+  else if (cobiwm_grab_op_is_resizing (window->display->grab_op))
+    update_resize (window, snap, x, y, FALSE);
+}
+
+static gboolean
+grab_motion_func (gpointer data)
+{
+  CobiwmWindow *window = data;
+  CobiwmDisplay *display = window->display;
+
+  display->grab_motion_later_id = 0;
+
+  apply_grab_motion (window,
+                     display->grab_pending_motion_snap,
+                     display->grab_pending_motion_x,
+                     display->grab_pending_motion_y);
+
+  return FALSE;
+}
+
+/* Pointers can report motion much more often than we can usefully run
+ * edge resistance and the constraints and send configure requests, so
+ * only remember the latest position and apply it once before the next
+ * frame is drawn.  Clients using _NET_WM_SYNC_REQUEST are still throttled
+ * further by update_resize().
+ */
+static void
+queue_grab_motion (CobiwmWindow *window,
+                   gboolean    snap,
+                   int         x,
+                   int         y)
+{
+  CobiwmDisplay *display = window->display;
+
+  display->grab_pending_motion_snap = snap;
+  display->grab_pending_motion_x = x;
+  display->grab_pending_motion_y = y;
+
+  if (!display->grab_motion_later_id)
+    display->grab_motion_later_id = cobiwm_later_add (COBIWM_LATER_BEFORE_REDRAW,
+                                                    grab_motion_func,
+                                                    window,
+                                                    NULL);
+}
+
+/* Apply any queued motion now, so that it isn't reordered with the
+ * button event which is about to be handled.
+ */
+static void
+flush_grab_motion (CobiwmWindow *window)
+{
+  CobiwmDisplay *display = window->display;
+
+  if (!display->grab_motion_later_id)
+    return;
+
+  cobiwm_later_remove (display->grab_motion_later_id);
+  grab_motion_func (window);
+}
+
 static void
 end_grab_op (CobiwmWindow *window,
              const ClutterEvent *event)
@@ -5903,6 +5982,8 @@ end_grab_op (CobiwmWindow *window,
   ClutterModifierType modifiers;
   gfloat x, y;
 
+  flush_grab_motion (window);
+
   clutter_event_get_coords (event, &x, &y);
   modifiers = clutter_event_get_state (event);
   cobiwm_display_check_threshold_reached (window->display, x, y);
@@ -6002,19 +6083,9 @@ cobiwm_window_handle_mouse_grab_op_event  (CobiwmWindow         *window,
       clutter_event_get_coords (event, &x, &y);
 
       cobiwm_display_check_threshold_reached (window->display, x, y);
-      if (cobiwm_grab_op_is_moving (window->display->grab_op))
-        {
-          update_move (window,
-                       modifier_state & CLUTTER_SHIFT_MASK,
-                       x, y);
-        }
-      else if (cobiwm_grab_op_is_resizing (window->display->grab_op))
-        {
-          update_resize (window,
+      queue_grab_motion (window,
                          modifier_state & CLUTTER_SHIFT_MASK,
-                         x, y,
-                         FALSE);
-        }
+                         x, y);
       return TRUE;
 
     default:
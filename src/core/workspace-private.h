@@ -56,8 +56,8 @@ struct _CobiwmWorkspace
 
   CobiwmRectangle work_area_screen;
   CobiwmRectangle *work_area_monitor;
-  GList  *screen_region;
-  GList  **monitor_region;
+  GArray *screen_region;
+  GArray **monitor_region;
   gint n_monitor_regions;
   GList  *screen_edges;
   GList  *monitor_edges;
@@ -84,8 +84,8 @@ void           cobiwm_workspace_relocate_windows (CobiwmWorkspace *workspace,
 
 void cobiwm_workspace_invalidate_work_area (CobiwmWorkspace *workspace);
 
-GList* cobiwm_workspace_get_onscreen_region       (CobiwmWorkspace *workspace);
-GList* cobiwm_workspace_get_onmonitor_region      (CobiwmWorkspace *workspace,
+GArray* cobiwm_workspace_get_onscreen_region      (CobiwmWorkspace *workspace);
+GArray* cobiwm_workspace_get_onmonitor_region     (CobiwmWorkspace *workspace,
                                                  int            which_monitor);
 
 void cobiwm_workspace_focus_default_window (CobiwmWorkspace *workspace,
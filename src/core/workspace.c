@@ -178,6 +178,8 @@ cobiwm_workspace_new (CobiwmScreen *screen)
   workspace->screen = screen;
   workspace->screen->workspaces =
     g_list_append (workspace->screen->workspaces, workspace);
+  /* Windows on all workspaces get another work area to fit in */
+  cobiwm_display_invalidate_constraint_cache (screen->display);
   workspace->windows = NULL;
   workspace->mru_list = NULL;
 
@@ -277,6 +279,7 @@ cobiwm_workspace_remove (CobiwmWorkspace *workspace)
 
   workspace->screen->workspaces =
     g_list_remove (workspace->screen->workspaces, workspace);
+  cobiwm_display_invalidate_constraint_cache (screen->display);
 
   g_free (workspace->work_area_monitor);
 
@@ -296,9 +299,9 @@ cobiwm_workspace_remove (CobiwmWorkspace *workspace)
     {
       workspace_free_all_struts (workspace);
       for (i = 0; i < screen->n_monitor_infos; i++)
-        cobiwm_rectangle_free_list_and_elements (workspace->monitor_region[i]);
+        g_array_free (workspace->monitor_region[i], TRUE);
       g_free (workspace->monitor_region);
-      cobiwm_rectangle_free_list_and_elements (workspace->screen_region);
+      g_array_free (workspace->screen_region, TRUE);
       cobiwm_rectangle_free_list_and_elements (workspace->screen_edges);
       cobiwm_rectangle_free_list_and_elements (workspace->monitor_edges);
     }
@@ -490,6 +493,7 @@ cobiwm_workspace_activate_with_focus (CobiwmWorkspace *workspace,
   /* Free any cached pointers to the workspaces's edges from
    * a current resize or move operation */
   cobiwm_display_cleanup_edges (workspace->screen->display);
+  cobiwm_display_invalidate_constraint_cache (workspace->screen->display);
 
   if (workspace->screen->active_workspace)
     workspace_switch_sound (workspace->screen->active_workspace, workspace);
@@ -700,15 +704,18 @@ cobiwm_workspace_invalidate_work_area (CobiwmWorkspace *workspace)
   if (workspace == workspace->screen->active_workspace)
     cobiwm_display_cleanup_edges (workspace->screen->display);
 
+  /* The work areas of windows on this workspace may change */
+  cobiwm_display_invalidate_constraint_cache (workspace->screen->display);
+
   g_free (workspace->work_area_monitor);
   workspace->work_area_monitor = NULL;
 
   workspace_free_all_struts (workspace);
 
   for (i = 0; i < workspace->screen->n_monitor_infos; i++)
-    cobiwm_rectangle_free_list_and_elements (workspace->monitor_region[i]);
+    g_array_free (workspace->monitor_region[i], TRUE);
   g_free (workspace->monitor_region);
-  cobiwm_rectangle_free_list_and_elements (workspace->screen_region);
+  g_array_free (workspace->screen_region, TRUE);
   cobiwm_rectangle_free_list_and_elements (workspace->screen_edges);
   cobiwm_rectangle_free_list_and_elements (workspace->monitor_edges);
   workspace->monitor_region = NULL;
@@ -789,17 +796,17 @@ ensure_work_areas_validated (CobiwmWorkspace *workspace)
   g_assert (workspace->monitor_region == NULL);
   g_assert (workspace->screen_region   == NULL);
 
-  workspace->monitor_region = g_new (GList*,
+  workspace->monitor_region = g_new (GArray*,
                                       workspace->screen->n_monitor_infos);
   for (i = 0; i < workspace->screen->n_monitor_infos; i++)
     {
       workspace->monitor_region[i] =
-        cobiwm_rectangle_get_minimal_spanning_set_for_region (
+        cobiwm_rectangle_get_minimal_spanning_array_for_region (
           &workspace->screen->monitor_infos[i].rect,
           workspace->all_struts);
     }
   workspace->screen_region =
-    cobiwm_rectangle_get_minimal_spanning_set_for_region (
+    cobiwm_rectangle_get_minimal_spanning_array_for_region (
       &workspace->screen->rect,
       workspace->all_struts);
 
@@ -807,12 +814,12 @@ ensure_work_areas_validated (CobiwmWorkspace *workspace)
    *         monitors.
    */
   work_area = workspace->screen->rect;  /* start with the screen */
-  if (workspace->screen_region == NULL)
+  if (workspace->screen_region->len == 0)
     work_area = cobiwm_rect (0, 0, -1, -1);
   else
-    cobiwm_rectangle_clip_to_region (workspace->screen_region,
-                                   FIXED_DIRECTION_NONE,
-                                   &work_area);
+    cobiwm_rectangle_clip_to_region_array (workspace->screen_region,
+                                         FIXED_DIRECTION_NONE,
+                                         &work_area);
 
   /* Lots of paranoia checks, forcing work_area_screen to be sane */
 #define MIN_SANE_AREA 100
@@ -868,15 +875,15 @@ ensure_work_areas_validated (CobiwmWorkspace *workspace)
     {
       work_area = workspace->screen->monitor_infos[i].rect;
 
-      if (workspace->monitor_region[i] == NULL)
+      if (workspace->monitor_region[i]->len == 0)
         /* FIXME: constraints.c untested with this, but it might be nice for
          * a screen reader or magnifier.
          */
         work_area = cobiwm_rect (work_area.x, work_area.y, -1, -1);
       else
-        cobiwm_rectangle_clip_to_region (workspace->monitor_region[i],
-                                       FIXED_DIRECTION_NONE,
-                                       &work_area);
+        cobiwm_rectangle_clip_to_region_array (workspace->monitor_region[i],
+                                             FIXED_DIRECTION_NONE,
+                                             &work_area);
 
       workspace->work_area_monitor[i] = work_area;
       cobiwm_topic (COBIWM_DEBUG_WORKAREA,
@@ -893,13 +900,8 @@ ensure_work_areas_validated (CobiwmWorkspace *workspace)
   /* STEP 4: Make sure the screen_region is nonempty (separate from step 2
    *         since it relies on step 3).
    */
-  if (workspace->screen_region == NULL)
-    {
-      CobiwmRectangle *nonempty_region;
-      nonempty_region = g_new (CobiwmRectangle, 1);
-      *nonempty_region = workspace->work_area_screen;
-      workspace->screen_region = g_list_prepend (NULL, nonempty_region);
-    }
+  if (workspace->screen_region->len == 0)
+    g_array_append_val (workspace->screen_region, workspace->work_area_screen);
 
   /* STEP 5: Cache screen and monitor edges for edge resistance and snapping */
   g_assert (workspace->screen_edges    == NULL);
@@ -1038,7 +1040,7 @@ cobiwm_workspace_get_work_area_all_monitors (CobiwmWorkspace *workspace,
   *area = workspace->work_area_screen;
 }
 
-GList*
+GArray*
 cobiwm_workspace_get_onscreen_region (CobiwmWorkspace *workspace)
 {
   ensure_work_areas_validated (workspace);
@@ -1046,7 +1048,7 @@ cobiwm_workspace_get_onscreen_region (CobiwmWorkspace *workspace)
   return workspace->screen_region;
 }
 
-GList*
+GArray*
 cobiwm_workspace_get_onmonitor_region (CobiwmWorkspace *workspace,
                                      int            which_monitor)
 {
@@ -23,6 +23,7 @@
 #define COBIWM_ERRORS_H
 
 #include <X11/Xlib.h>
+#include <xcb/xcb.h>
 
 #include <util.h>
 #include <display.h>
@@ -33,5 +34,11 @@ void      cobiwm_error_trap_pop  (CobiwmDisplay *display);
 /* returns X error code, or 0 for no error */
 int       cobiwm_error_trap_pop_with_return  (CobiwmDisplay *display);
 
+/* Deferred checking of requests made with the _checked() xcb calls */
+int       cobiwm_error_check_cookie  (CobiwmDisplay       *display,
+                                    xcb_void_cookie_t  cookie);
+void      cobiwm_error_ignore_cookie (CobiwmDisplay       *display,
+                                    xcb_void_cookie_t  cookie);
+
 
 #endif
@@ -100,6 +100,9 @@ typedef enum
   COBIWM_PREF_AUTO_MAXIMIZE,
   COBIWM_PREF_CENTER_NEW_WINDOWS,
   COBIWM_PREF_DRAG_THRESHOLD,
+
+  /* Not a preference; keep it last */
+  COBIWM_PREF_LAST /*< skip >*/
 } CobiwmPreference;
 
 typedef void (* CobiwmPrefsChangedFunc) (CobiwmPreference pref,
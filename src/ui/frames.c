@@ -193,9 +193,16 @@ update_style_contexts (CobiwmFrames *frames)
 static void
 cobiwm_frames_init (CobiwmFrames *frames)
 {
-  frames->text_heights = g_hash_table_new (NULL, NULL);
+  frames->text_heights =
+    g_hash_table_new_full ((GHashFunc) pango_font_description_hash,
+                           (GEqualFunc) pango_font_description_equal,
+                           (GDestroyNotify) pango_font_description_free,
+                           NULL);
+  frames->title_layouts = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                 g_free, NULL);
 
   frames->frames = g_hash_table_new (unsigned_long_hash, unsigned_long_equal);
+  g_queue_init (&frames->pooled_windows);
 
   frames->style_variants = g_hash_table_new_full (g_str_hash, g_str_equal,
                                                   g_free, (GDestroyNotify)cobiwm_style_info_unref);
@@ -234,6 +241,10 @@ cobiwm_frames_destroy (GtkWidget *object)
     }
   g_slist_free (winlist);
 
+  g_queue_free_full (&frames->pooled_windows,
+                     (GDestroyNotify) gdk_window_destroy);
+  g_queue_init (&frames->pooled_windows);
+
   if (frames->normal_style)
     {
       cobiwm_style_info_unref (frames->normal_style);
@@ -259,6 +270,7 @@ cobiwm_frames_finalize (GObject *object)
   cobiwm_prefs_remove_listener (prefs_changed_callback, frames);
 
   g_hash_table_destroy (frames->text_heights);
+  g_hash_table_destroy (frames->title_layouts);
 
   g_assert (g_hash_table_size (frames->frames) == 0);
   g_hash_table_destroy (frames->frames);
@@ -276,16 +288,14 @@ queue_recalc_func (gpointer key, gpointer value, gpointer data)
                                 frame->xwindow);
 
   g_clear_object (&frame->text_layout);
+  frame->fgeom_valid = FALSE;
 }
 
 static void
 cobiwm_frames_font_changed (CobiwmFrames *frames)
 {
-  if (g_hash_table_size (frames->text_heights) > 0)
-    {
-      g_hash_table_destroy (frames->text_heights);
-      frames->text_heights = g_hash_table_new (NULL, NULL);
-    }
+  g_hash_table_remove_all (frames->text_heights);
+  g_hash_table_remove_all (frames->title_layouts);
 
   /* Queue a draw/resize on all frames */
   g_hash_table_foreach (frames->frames,
@@ -332,6 +342,102 @@ cobiwm_frames_style_updated  (GtkWidget *widget)
   GTK_WIDGET_CLASS (cobiwm_frames_parent_class)->style_updated (widget);
 }
 
+/**
+ * cobiwm_frames_get_text_height:
+ * @frames: a #CobiwmFrames
+ * @font_desc: the (already scaled) title font
+ *
+ * Looks up the height of title text in @font_desc, measuring the font
+ * only the first time it is asked for.
+ *
+ * Returns: the height of the letters
+ */
+int
+cobiwm_frames_get_text_height (CobiwmFrames               *frames,
+                             const PangoFontDescription *font_desc)
+{
+  gpointer value;
+  int text_height;
+
+  if (g_hash_table_lookup_extended (frames->text_heights, font_desc,
+                                    NULL, &value))
+    return GPOINTER_TO_INT (value);
+
+  text_height =
+    cobiwm_pango_font_desc_get_text_height (font_desc,
+                                          gtk_widget_get_pango_context (GTK_WIDGET (frames)));
+
+  g_hash_table_insert (frames->text_heights,
+                       pango_font_description_copy (font_desc),
+                       GINT_TO_POINTER (text_height));
+
+  return text_height;
+}
+
+typedef struct
+{
+  CobiwmFrames *frames;
+  char *key;
+  PangoLayout *layout;
+} TitleLayoutEntry;
+
+static void
+title_layout_entry_free (gpointer data)
+{
+  TitleLayoutEntry *entry = data;
+
+  /* A font change may have replaced the entry already */
+  if (g_hash_table_lookup (entry->frames->title_layouts, entry->key) == entry->layout)
+    g_hash_table_remove (entry->frames->title_layouts, entry->key);
+
+  g_free (entry->key);
+  g_slice_free (TitleLayoutEntry, entry);
+}
+
+/* Frames with the same title and font (a row of terminals, say) share
+ * one layout, so the title is only shaped once. The table does not own
+ * the layouts; each one drops out of it when its last frame lets go.
+ */
+static PangoLayout *
+get_title_layout (CobiwmFrames               *frames,
+                  const PangoFontDescription *font_desc,
+                  const char                 *title)
+{
+  TitleLayoutEntry *entry;
+  PangoLayout *layout;
+  char *font_name;
+  char *key;
+
+  font_name = pango_font_description_to_string (font_desc);
+  key = g_strconcat (font_name, "\n", title ? title : "", NULL);
+  g_free (font_name);
+
+  layout = g_hash_table_lookup (frames->title_layouts, key);
+  if (layout)
+    {
+      g_free (key);
+      return g_object_ref (layout);
+    }
+
+  layout = gtk_widget_create_pango_layout (GTK_WIDGET (frames), title);
+
+  pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_END);
+  pango_layout_set_auto_dir (layout, FALSE);
+  pango_layout_set_single_paragraph_mode (layout, TRUE);
+  pango_layout_set_font_description (layout, font_desc);
+
+  entry = g_slice_new (TitleLayoutEntry);
+  entry->frames = frames;
+  entry->key = g_strdup (key);
+  entry->layout = layout;
+  g_object_set_data_full (G_OBJECT (layout), "cobiwm-title-layout-entry",
+                          entry, title_layout_entry_free);
+
+  g_hash_table_insert (frames->title_layouts, key, layout);
+
+  return layout;
+}
+
 static void
 cobiwm_ui_frame_ensure_layout (CobiwmUIFrame    *frame,
                              CobiwmFrameType   type)
@@ -353,40 +459,13 @@ cobiwm_ui_frame_ensure_layout (CobiwmUIFrame    *frame,
 
   if (frame->text_layout == NULL)
     {
-      gpointer key, value;
       PangoFontDescription *font_desc;
-      int size;
-
-      frame->text_layout = gtk_widget_create_pango_layout (widget, frame->title);
-
-      pango_layout_set_ellipsize (frame->text_layout, PANGO_ELLIPSIZE_END);
-      pango_layout_set_auto_dir (frame->text_layout, FALSE);
-      pango_layout_set_single_paragraph_mode (frame->text_layout, TRUE);
 
       font_desc = cobiwm_style_info_create_font_desc (frame->style_info);
       cobiwm_frame_layout_apply_scale (layout, font_desc);
 
-      size = pango_font_description_get_size (font_desc);
-
-      if (g_hash_table_lookup_extended (frames->text_heights,
-                                        GINT_TO_POINTER (size),
-                                        &key, &value))
-        {
-          frame->text_height = GPOINTER_TO_INT (value);
-        }
-      else
-        {
-          frame->text_height =
-            cobiwm_pango_font_desc_get_text_height (font_desc,
-                                                  gtk_widget_get_pango_context (widget));
-
-          g_hash_table_replace (frames->text_heights,
-                                GINT_TO_POINTER (size),
-                                GINT_TO_POINTER (frame->text_height));
-        }
-
-      pango_layout_set_font_description (frame->text_layout,
-                                         font_desc);
+      frame->text_height = cobiwm_frames_get_text_height (frames, font_desc);
+      frame->text_layout = get_title_layout (frames, font_desc, frame->title);
 
       pango_font_description_free (font_desc);
     }
@@ -396,28 +475,43 @@ static void
 cobiwm_ui_frame_calc_geometry (CobiwmUIFrame       *frame,
                              CobiwmFrameGeometry *fgeom)
 {
-  CobiwmFrameFlags flags;
-  CobiwmFrameType type;
-  CobiwmButtonLayout button_layout;
+  CobiwmFrameGeometryKey key;
   CobiwmWindowX11 *window_x11 = COBIWM_WINDOW_X11 (frame->cobiwm_window);
   CobiwmWindowX11Private *priv = window_x11->priv;
 
-  flags = cobiwm_frame_get_flags (frame->cobiwm_window->frame);
-  type = cobiwm_window_get_frame_type (frame->cobiwm_window);
+  memset (&key, 0, sizeof key);
+  key.flags = cobiwm_frame_get_flags (frame->cobiwm_window->frame);
+  key.type = cobiwm_window_get_frame_type (frame->cobiwm_window);
+  key.client_width = priv->client_rect.width;
+  key.client_height = priv->client_rect.height;
+  key.scale = cobiwm_theme_get_window_scaling_factor ();
 
-  cobiwm_ui_frame_ensure_layout (frame, type);
+  cobiwm_ui_frame_ensure_layout (frame, key.type);
+  key.text_height = frame->text_height;
 
-  cobiwm_prefs_get_button_layout (&button_layout);
+  cobiwm_prefs_get_button_layout (&key.button_layout);
 
-  cobiwm_theme_calc_geometry (cobiwm_theme_get_default (),
-                            frame->style_info,
-                            type,
-                            frame->text_height,
-                            flags,
-                            priv->client_rect.width,
-                            priv->client_rect.height,
-                            &button_layout,
-                            fgeom);
+  /* Hit-testing on every pointer motion ends up here, and the geometry
+   * rarely changes in between; only recompute it when an input did.
+   */
+  if (!frame->fgeom_valid ||
+      memcmp (&key, &frame->fgeom_key, sizeof key) != 0)
+    {
+      cobiwm_theme_calc_geometry (cobiwm_theme_get_default (),
+                                frame->style_info,
+                                key.type,
+                                key.text_height,
+                                key.flags,
+                                key.client_width,
+                                key.client_height,
+                                &key.button_layout,
+                                &frame->fgeom);
+
+      frame->fgeom_key = key;
+      frame->fgeom_valid = TRUE;
+    }
+
+  *fgeom = frame->fgeom;
 }
 
 CobiwmFrames*
@@ -471,12 +565,16 @@ get_global_theme_variant (CobiwmFrames *frames)
 static void
 cobiwm_ui_frame_attach_style (CobiwmUIFrame *frame)
 {
+  static guint style_serial = 0;
   CobiwmFrames *frames = frame->frames;
   const char *variant;
 
   if (frame->style_info != NULL)
     cobiwm_style_info_unref (frame->style_info);
 
+  frame->fgeom_valid = FALSE;
+  frame->style_serial = ++style_serial;
+
   variant = frame->cobiwm_window->gtk_theme_variant;
   if (variant == NULL)
     variant = get_global_theme_variant (frame->frames);;
@@ -506,6 +604,7 @@ cobiwm_frames_manage_window (CobiwmFrames *frames,
   gdk_window_set_user_data (frame->window, frames);
 
   frame->style_info = NULL;
+  frame->style_serial = 0;
 
   /* Don't set event mask here, it's in frame.c */
 
@@ -515,6 +614,7 @@ cobiwm_frames_manage_window (CobiwmFrames *frames,
   frame->text_layout = NULL;
   frame->text_height = -1;
   frame->title = NULL;
+  frame->fgeom_valid = FALSE;
   frame->prelit_control = COBIWM_FRAME_CONTROL_NONE;
   frame->button_state = COBIWM_BUTTON_STATE_NORMAL;
 
@@ -525,6 +625,59 @@ cobiwm_frames_manage_window (CobiwmFrames *frames,
   return frame;
 }
 
+/* Frame windows come and go with every dialog and menu; keep a few
+ * around rather than having the server set new ones up each time.
+ */
+#define MAX_POOLED_FRAME_WINDOWS 8
+
+static void
+pool_frame_window (CobiwmFrames *frames,
+                   GdkWindow  *window)
+{
+  if (g_queue_get_length (&frames->pooled_windows) >= MAX_POOLED_FRAME_WINDOWS)
+    {
+      gdk_window_destroy (window);
+      return;
+    }
+
+  /* gdk_window_destroy() would have dropped these along with the
+   * window; the next frame grabs what it needs itself.
+   */
+  cobiwm_core_ungrab_all (GDK_WINDOW_XDISPLAY (window),
+                        GDK_WINDOW_XID (window));
+
+  gdk_window_hide (window);
+  g_queue_push_head (&frames->pooled_windows, window);
+}
+
+/**
+ * cobiwm_frames_take_pooled_window:
+ * @frames: a #CobiwmFrames
+ * @visual: the visual the window has to have
+ *
+ * Returns: (transfer full) (nullable): the hidden window of a frame
+ *   that was unmanaged earlier, if there is one with @visual.
+ */
+GdkWindow *
+cobiwm_frames_take_pooled_window (CobiwmFrames *frames,
+                                GdkVisual  *visual)
+{
+  GList *l;
+
+  for (l = frames->pooled_windows.head; l; l = l->next)
+    {
+      GdkWindow *window = l->data;
+
+      if (gdk_window_get_visual (window) == visual)
+        {
+          g_queue_delete_link (&frames->pooled_windows, l);
+          return window;
+        }
+    }
+
+  return NULL;
+}
+
 void
 cobiwm_ui_frame_unmanage (CobiwmUIFrame *frame)
 {
@@ -541,7 +694,7 @@ cobiwm_ui_frame_unmanage (CobiwmUIFrame *frame)
 
   cobiwm_style_info_unref (frame->style_info);
 
-  gdk_window_destroy (frame->window);
+  pool_frame_window (frames, frame->window);
 
   if (frame->text_layout)
     g_object_unref (G_OBJECT (frame->text_layout));
@@ -725,16 +878,52 @@ cobiwm_ui_frame_queue_draw (CobiwmUIFrame *frame)
   invalidate_whole_window (frame);
 }
 
+/* The title is centered within the titlebar and clamped to the title
+ * rect, so a new title only touches the title rect's columns of the
+ * titlebar.
+ */
+static void
+invalidate_title (CobiwmUIFrame *frame)
+{
+  CobiwmFrameGeometry fgeom;
+  GdkRectangle rect;
+
+  cobiwm_ui_frame_calc_geometry (frame, &fgeom);
+
+  rect.x = fgeom.title_rect.x;
+  rect.y = fgeom.borders.invisible.top;
+  rect.width = fgeom.title_rect.width;
+  rect.height = fgeom.borders.visible.top;
+
+  if (rect.width > 0 && rect.height > 0)
+    gdk_window_invalidate_rect (frame->window, &rect, FALSE);
+}
+
 void
 cobiwm_ui_frame_set_title (CobiwmUIFrame *frame,
                          const char *title)
 {
+  if (g_strcmp0 (frame->title, title) == 0)
+    return;
+
   g_free (frame->title);
   frame->title = g_strdup (title);
 
-  g_clear_object (&frame->text_layout);
+  /* The font and text height don't depend on the title, so only the
+   * layout needs replacing.
+   */
+  if (frame->text_layout)
+    {
+      PangoLayout *layout = frame->text_layout;
 
-  invalidate_whole_window (frame);
+      frame->text_layout =
+        get_title_layout (frame->frames,
+                          pango_layout_get_font_description (layout),
+                          frame->title);
+      g_object_unref (layout);
+    }
+
+  invalidate_title (frame);
 }
 
 void
@@ -755,6 +944,12 @@ redraw_control (CobiwmUIFrame *frame,
 
   rect = control_rect (control, &fgeom);
 
+  /* Controls without a rect (resize edges, none) are not drawn
+   * differently when prelit; don't let them invalidate the whole frame.
+   */
+  if (rect == NULL)
+    return;
+
   gdk_window_invalidate_rect (frame->window, rect, FALSE);
 }
 
@@ -1249,7 +1444,8 @@ cobiwm_ui_frame_update_prelit_control (CobiwmUIFrame     *frame,
   frame->prelit_control = control;
 
   redraw_control (frame, old_control);
-  redraw_control (frame, control);
+  if (control != old_control)
+    redraw_control (frame, control);
 }
 
 static gboolean
@@ -1340,6 +1536,15 @@ get_visible_frame_border_region (CobiwmUIFrame *frame)
  * @xwindow: The X window for the frame, which has the client window as a child
  * @cr: Used to draw the resulting mask
  */
+/* Lets users of cobiwm_ui_frame_get_mask() tell when the frame may
+ * look different at the same size, e.g. after a theme change.
+ */
+guint
+cobiwm_ui_frame_get_style_serial (CobiwmUIFrame *frame)
+{
+  return frame->style_serial;
+}
+
 void
 cobiwm_ui_frame_get_mask (CobiwmUIFrame *frame,
                         cairo_t     *cr)
@@ -1392,6 +1597,7 @@ cobiwm_frames_draw (GtkWidget *widget,
   CobiwmUIFrame *frame;
   CobiwmFrames *frames;
   cairo_region_t *region;
+  GdkRectangle clip;
 
   frames = COBIWM_FRAMES (widget);
 
@@ -1399,7 +1605,19 @@ cobiwm_frames_draw (GtkWidget *widget,
   if (frame == NULL)
     return FALSE;
 
+  /* Only the damaged part of the border is cleared and repainted */
+  if (!gdk_cairo_get_clip_rectangle (cr, &clip))
+    return TRUE;
+
   region = get_visible_frame_border_region (frame);
+  cairo_region_intersect_rectangle (region, &clip);
+
+  if (cairo_region_is_empty (region))
+    {
+      cairo_region_destroy (region);
+      return TRUE;
+    }
+
   gdk_cairo_region (cr, region);
   cairo_clip (cr);
 
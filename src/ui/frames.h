@@ -64,6 +64,21 @@ typedef enum
 typedef struct _CobiwmFrames        CobiwmFrames;
 typedef struct _CobiwmFramesClass   CobiwmFramesClass;
 
+/* Everything cobiwm_theme_calc_geometry() depends on besides the
+ * style info; compared with memcmp(), so it must be zeroed before
+ * being filled in.
+ */
+typedef struct
+{
+  CobiwmFrameType type;
+  CobiwmFrameFlags flags;
+  int client_width;
+  int client_height;
+  int text_height;
+  int scale;
+  CobiwmButtonLayout button_layout;
+} CobiwmFrameGeometryKey;
+
 struct _CobiwmUIFrame
 {
   CobiwmFrames *frames;
@@ -71,12 +86,18 @@ struct _CobiwmUIFrame
   Window xwindow;
   GdkWindow *window;
   CobiwmStyleInfo *style_info;
+  guint style_serial; /* changes whenever style_info is (re)attached */
   CobiwmFrameLayout *cache_layout;
   PangoLayout *text_layout;
   int text_height;
   char *title; /* NULL once we have a layout */
   guint maybe_ignore_leave_notify : 1;
 
+  /* Last geometry computed for this frame, see cobiwm_ui_frame_calc_geometry() */
+  guint fgeom_valid : 1;
+  CobiwmFrameGeometryKey fgeom_key;
+  CobiwmFrameGeometry fgeom;
+
   /* FIXME get rid of this, it can just be in the CobiwmFrames struct */
   CobiwmFrameControl prelit_control;
   CobiwmButtonState button_state;
@@ -87,10 +108,15 @@ struct _CobiwmFrames
 {
   GtkWindow parent_instance;
 
+  /* Font metrics and shaped title layouts, shared between frames */
   GHashTable *text_heights;
+  GHashTable *title_layouts;
 
   GHashTable *frames;
 
+  /* Windows of unmanaged frames, hidden and kept around for new ones */
+  GQueue pooled_windows;
+
   CobiwmStyleInfo *normal_style;
   GHashTable *style_variants;
 
@@ -118,6 +144,12 @@ CobiwmUIFrame * cobiwm_frames_manage_window (CobiwmFrames *frames,
 
 void cobiwm_ui_frame_unmanage (CobiwmUIFrame *frame);
 
+int cobiwm_frames_get_text_height (CobiwmFrames               *frames,
+                                 const PangoFontDescription *font_desc);
+
+GdkWindow * cobiwm_frames_take_pooled_window (CobiwmFrames *frames,
+                                            GdkVisual  *visual);
+
 void cobiwm_ui_frame_set_title (CobiwmUIFrame *frame,
                               const char *title);
 
@@ -130,6 +162,7 @@ cairo_region_t * cobiwm_ui_frame_get_bounds (CobiwmUIFrame *frame);
 
 void cobiwm_ui_frame_get_mask (CobiwmUIFrame *frame,
                              cairo_t     *cr);
+guint cobiwm_ui_frame_get_style_serial (CobiwmUIFrame *frame);
 
 void cobiwm_ui_frame_move_resize (CobiwmUIFrame *frame,
                                 int x, int y, int width, int height);
@@ -183,6 +183,9 @@ struct _CobiwmStyleInfo
   int refcount;
 
   GtkStyleContext *styles[COBIWM_STYLE_ELEMENT_LAST];
+
+  /* Rendered titlebar buttons, see get_button_piece() */
+  GHashTable *button_pieces;
 };
 
 /* Kinds of frame...
@@ -717,6 +717,188 @@ get_class_from_button_type (CobiwmButtonType type)
     }
 }
 
+/* Renders the background, frame and icon of a button whose top left
+ * corner is at the origin of @cr; @style must already be in the state
+ * of the button.
+ */
+static void
+render_button (GtkStyleContext         *style,
+               cairo_t                 *cr,
+               const CobiwmFrameLayout *layout,
+               CobiwmFrameFlags         flags,
+               CobiwmButtonType         button_type,
+               int                      width,
+               int                      height,
+               int                      scale,
+               cairo_surface_t         *mini_icon)
+{
+  cairo_surface_t *surface = NULL;
+  const char *icon_name = NULL;
+
+  gtk_render_background (style, cr, 0, 0, width, height);
+  gtk_render_frame (style, cr, 0, 0, width, height);
+
+  switch (button_type)
+    {
+    case COBIWM_BUTTON_TYPE_CLOSE:
+       icon_name = "window-close-symbolic";
+       break;
+    case COBIWM_BUTTON_TYPE_MAXIMIZE:
+       if (flags & COBIWM_FRAME_MAXIMIZED)
+         icon_name = "window-restore-symbolic";
+       else
+         icon_name = "window-maximize-symbolic";
+       break;
+    case COBIWM_BUTTON_TYPE_MINIMIZE:
+       icon_name = "window-minimize-symbolic";
+       break;
+    case COBIWM_BUTTON_TYPE_MENU:
+       icon_name = "open-menu-symbolic";
+       break;
+    case COBIWM_BUTTON_TYPE_APPMENU:
+       if (mini_icon)
+         surface = cairo_surface_reference (mini_icon);
+       break;
+    default:
+       icon_name = NULL;
+       break;
+    }
+
+  if (icon_name)
+    {
+      GtkIconTheme *theme = gtk_icon_theme_get_default ();
+      GtkIconInfo *info;
+      GdkPixbuf *pixbuf;
+
+      info = gtk_icon_theme_lookup_icon_for_scale (theme, icon_name,
+                                                   layout->icon_size, scale, 0);
+      pixbuf = gtk_icon_info_load_symbolic_for_context (info, style, NULL, NULL);
+      surface = gdk_cairo_surface_create_from_pixbuf (pixbuf, scale, NULL);
+    }
+
+  if (surface)
+    {
+      float icon_width, icon_height;
+      int x, y;
+
+      icon_width = cairo_image_surface_get_width (surface) / scale;
+      icon_height = cairo_image_surface_get_height (surface) / scale;
+      x = (width - icon_width) / 2;
+      y = (height - icon_height) / 2;
+
+      cairo_translate (cr, x, y);
+      cairo_scale (cr,
+                   icon_width / layout->icon_size,
+                   icon_height / layout->icon_size);
+      cairo_set_source_surface (cr, surface, 0, 0);
+      cairo_paint (cr);
+
+      cairo_surface_destroy (surface);
+    }
+}
+
+/* Rendered buttons are kept per style info, keyed on everything that
+ * goes into drawing one; the key only needs the frame flags that
+ * cobiwm_style_info_set_flags() and render_button() look at.
+ */
+#define MAX_BUTTON_PIECES 128
+
+static gboolean
+get_button_piece_key (const CobiwmFrameLayout *layout,
+                      CobiwmFrameFlags         flags,
+                      CobiwmButtonType         button_type,
+                      CobiwmButtonState        button_state,
+                      int                      width,
+                      int                      height,
+                      int                      scale,
+                      guint64                 *key)
+{
+  gboolean backdrop;
+
+  if (width > G_MAXUINT16 || height > G_MAXUINT16 ||
+      layout->icon_size > G_MAXUINT8 || scale > 0xf)
+    return FALSE;
+
+  backdrop = !(flags & COBIWM_FRAME_HAS_FOCUS);
+  if (flags & COBIWM_FRAME_IS_FLASHING)
+    backdrop = !backdrop;
+
+  *key = ((guint64) width |
+          (guint64) height << 16 |
+          (guint64) layout->icon_size << 32 |
+          (guint64) scale << 40 |
+          (guint64) button_type << 44 |
+          (guint64) button_state << 49 |
+          (guint64) (backdrop != FALSE) << 51 |
+          (guint64) ((flags & COBIWM_FRAME_MAXIMIZED) != 0) << 52 |
+          (guint64) ((flags & (COBIWM_FRAME_TILED_LEFT |
+                               COBIWM_FRAME_TILED_RIGHT)) != 0) << 53);
+
+  return TRUE;
+}
+
+/* Returns the button rendered into an image surface, creating it the
+ * first time it is needed. CSS shadows and outlines may be drawn outside
+ * of the button itself, so the surface covers the whole clip and its
+ * device offset puts the button at the origin.
+ */
+static cairo_surface_t *
+get_button_piece (CobiwmStyleInfo         *style_info,
+                  const CobiwmFrameLayout *layout,
+                  CobiwmFrameFlags         flags,
+                  CobiwmButtonType         button_type,
+                  CobiwmButtonState        button_state,
+                  const GdkRectangle      *button_rect,
+                  int                      scale)
+{
+  GtkStyleContext *style = style_info->styles[COBIWM_STYLE_ELEMENT_BUTTON];
+  cairo_surface_t *piece;
+  GdkRectangle clip;
+  guint64 key;
+  cairo_t *cr;
+
+  if (!get_button_piece_key (layout, flags, button_type, button_state,
+                             button_rect->width, button_rect->height,
+                             scale, &key))
+    return NULL;
+
+  piece = g_hash_table_lookup (style_info->button_pieces, &key);
+  if (piece)
+    return piece;
+
+  if (g_hash_table_size (style_info->button_pieces) >= MAX_BUTTON_PIECES)
+    g_hash_table_remove_all (style_info->button_pieces);
+
+  gtk_render_background_get_clip (style, 0, 0,
+                                  button_rect->width, button_rect->height,
+                                  &clip);
+  gdk_rectangle_union (&clip, &(GdkRectangle) { 0, 0,
+                                                button_rect->width,
+                                                button_rect->height },
+                       &clip);
+
+  piece = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                      clip.width * scale,
+                                      clip.height * scale);
+  cairo_surface_set_device_scale (piece, scale, scale);
+  cairo_surface_set_device_offset (piece, -clip.x * scale, -clip.y * scale);
+
+  cr = cairo_create (piece);
+  render_button (style, cr, layout, flags, button_type,
+                 button_rect->width, button_rect->height, scale, NULL);
+  cairo_destroy (cr);
+
+  if (cairo_surface_status (piece) != CAIRO_STATUS_SUCCESS)
+    {
+      cairo_surface_destroy (piece);
+      return NULL;
+    }
+
+  g_hash_table_insert (style_info->button_pieces,
+                       g_memdup (&key, sizeof key), piece);
+  return piece;
+}
+
 static void
 cobiwm_frame_layout_draw_with_style (CobiwmFrameLayout         *layout,
                                    CobiwmStyleInfo           *style_info,
@@ -827,78 +1009,33 @@ cobiwm_frame_layout_draw_with_style (CobiwmFrameLayout         *layout,
       else
         gtk_style_context_set_state (style, state);
 
-      cairo_save (cr);
-
       if (button_rect.width > 0 && button_rect.height > 0)
         {
-          cairo_surface_t *surface = NULL;
-          const char *icon_name = NULL;
+          cairo_surface_t *piece = NULL;
 
-          gtk_render_background (style, cr,
-                                 button_rect.x, button_rect.y,
-                                 button_rect.width, button_rect.height);
-          gtk_render_frame (style, cr,
-                            button_rect.x, button_rect.y,
-                            button_rect.width, button_rect.height);
-
-          switch (button_type)
-            {
-            case COBIWM_BUTTON_TYPE_CLOSE:
-               icon_name = "window-close-symbolic";
-               break;
-            case COBIWM_BUTTON_TYPE_MAXIMIZE:
-               if (flags & COBIWM_FRAME_MAXIMIZED)
-                 icon_name = "window-restore-symbolic";
-               else
-                 icon_name = "window-maximize-symbolic";
-               break;
-            case COBIWM_BUTTON_TYPE_MINIMIZE:
-               icon_name = "window-minimize-symbolic";
-               break;
-            case COBIWM_BUTTON_TYPE_MENU:
-               icon_name = "open-menu-symbolic";
-               break;
-            case COBIWM_BUTTON_TYPE_APPMENU:
-               surface = cairo_surface_reference (mini_icon);
-               break;
-            default:
-               icon_name = NULL;
-               break;
-            }
+          /* The app menu button shows the window's own icon, so it is
+           * the one piece that cannot be shared between frames.
+           */
+          if (button_type != COBIWM_BUTTON_TYPE_APPMENU)
+            piece = get_button_piece (style_info, layout, flags, button_type,
+                                      button_states[button_type],
+                                      &button_rect, scale);
 
-          if (icon_name)
+          if (piece)
             {
-              GtkIconTheme *theme = gtk_icon_theme_get_default ();
-              GtkIconInfo *info;
-              GdkPixbuf *pixbuf;
-
-              info = gtk_icon_theme_lookup_icon_for_scale (theme, icon_name,
-                                                           layout->icon_size, scale, 0);
-              pixbuf = gtk_icon_info_load_symbolic_for_context (info, style, NULL, NULL);
-              surface = gdk_cairo_surface_create_from_pixbuf (pixbuf, scale, NULL);
+              cairo_set_source_surface (cr, piece, button_rect.x, button_rect.y);
+              cairo_paint (cr);
             }
-
-          if (surface)
+          else
             {
-              float width, height;
-              int x, y;
-
-              width = cairo_image_surface_get_width (surface) / scale;
-              height = cairo_image_surface_get_height (surface) / scale;
-              x = button_rect.x + (button_rect.width - width) / 2;
-              y = button_rect.y + (button_rect.height - height) / 2;
-
-              cairo_translate (cr, x, y);
-              cairo_scale (cr,
-                           width / layout->icon_size,
-                           height / layout->icon_size);
-              cairo_set_source_surface (cr, surface, 0, 0);
-              cairo_paint (cr);
-
-              cairo_surface_destroy (surface);
+              cairo_save (cr);
+              cairo_translate (cr, button_rect.x, button_rect.y);
+              render_button (style, cr, layout, flags, button_type,
+                             button_rect.width, button_rect.height,
+                             scale, mini_icon);
+              cairo_restore (cr);
             }
         }
-      cairo_restore (cr);
       if (button_class)
         gtk_style_context_remove_class (style, button_class);
       gtk_style_context_set_state (style, state);
@@ -1102,6 +1239,10 @@ cobiwm_theme_create_style_info (GdkScreen   *screen,
                           provider,
                           "image",
                           NULL);
+
+  style_info->button_pieces =
+    g_hash_table_new_full (g_int64_hash, g_int64_equal,
+                           g_free, (GDestroyNotify) cairo_surface_destroy);
   return style_info;
 }
 
@@ -1126,6 +1267,7 @@ cobiwm_style_info_unref (CobiwmStyleInfo *style_info)
       int i;
       for (i = 0; i < COBIWM_STYLE_ELEMENT_LAST; i++)
         g_object_unref (style_info->styles[i]);
+      g_hash_table_destroy (style_info->button_pieces);
       g_free (style_info);
     }
 }
@@ -135,7 +135,8 @@ cobiwm_ui_create_frame (CobiwmUI *ui,
                       gint y,
                       gint width,
                       gint height,
-                      gulong *create_serial)
+                      gulong *create_serial,
+                      gboolean *reused)
 {
   GdkDisplay *display = gdk_x11_lookup_xdisplay (xdisplay);
   GdkScreen *screen = gdk_display_get_default_screen (display);
@@ -157,6 +158,20 @@ cobiwm_ui_create_frame (CobiwmUI *ui,
                                              XVisualIDFromVisual (xvisual));
     }
 
+  /* A window from a frame that went away recently already exists on
+   * the server, with everything below set up.
+   */
+  window = cobiwm_frames_take_pooled_window (ui->frames, visual);
+  if (window)
+    {
+      gdk_window_move_resize (window, x, y, width, height);
+      *reused = TRUE;
+
+      return cobiwm_frames_manage_window (ui->frames, cobiwm_window, GDK_WINDOW_XID (window), window);
+    }
+
+  *reused = FALSE;
+
   attrs.title = NULL;
 
   attrs.event_mask = GDK_EXPOSURE_MASK;
@@ -246,16 +261,11 @@ cobiwm_ui_theme_get_frame_borders (CobiwmUI *ui,
 {
   int text_height;
   CobiwmStyleInfo *style_info = NULL;
-  PangoContext *context;
   const PangoFontDescription *font_desc;
   PangoFontDescription *free_font_desc = NULL;
 
-  GdkDisplay *display = gdk_x11_lookup_xdisplay (ui->xdisplay);
-  GdkScreen *screen = gdk_display_get_default_screen (display);
-
-  style_info = cobiwm_theme_create_style_info (screen, NULL);
+  style_info = cobiwm_style_info_ref (ui->frames->normal_style);
 
-  context = gtk_widget_get_pango_context (GTK_WIDGET (ui->frames));
   font_desc = cobiwm_prefs_get_titlebar_font ();
 
   if (!font_desc)
@@ -264,7 +274,7 @@ cobiwm_ui_theme_get_frame_borders (CobiwmUI *ui,
       font_desc = (const PangoFontDescription *) free_font_desc;
     }
 
-  text_height = cobiwm_pango_font_desc_get_text_height (font_desc, context);
+  text_height = cobiwm_frames_get_text_height (ui->frames, font_desc);
 
   cobiwm_theme_get_frame_borders (cobiwm_theme_get_default (),
                                 style_info, type, text_height, flags,
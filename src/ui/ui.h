@@ -57,7 +57,8 @@ CobiwmUIFrame * cobiwm_ui_create_frame (CobiwmUI *ui,
                                     gint y,
                                     gint width,
                                     gint height,
-                                    gulong *create_serial);
+                                    gulong *create_serial,
+                                    gboolean *reused);
 void cobiwm_ui_move_resize_frame (CobiwmUI *ui,
 				Window frame,
 				int x,
@@ -0,0 +1,333 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+
+/*
+ * SECTION:event-trace-tool
+ * @short_description: reads back event traces
+ *
+ * Summarizes the traces Cobiwm writes when COBIWM_EVENT_TRACE is set,
+ * see event-trace.h: how many events of each type were handled, how
+ * long that took and how many requests it made, which events were the
+ * slowest, and how all of that changed between two traces of the
+ * same session.
+ */
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "x11/event-trace.h"
+
+typedef struct
+{
+  guint32 type;
+  guint32 evtype;
+  guint   count;
+  gint64  total_duration;
+  gint64  max_duration;
+  guint64 total_requests;
+} TypeStats;
+
+typedef struct
+{
+  CobiwmEventTraceRecord *records;
+  gsize n_records;
+  GArray *stats;
+} Trace;
+
+static const char *core_event_names[] = {
+  NULL, NULL, "KeyPress", "KeyRelease", "ButtonPress", "ButtonRelease",
+  "MotionNotify", "EnterNotify", "LeaveNotify", "FocusIn", "FocusOut",
+  "KeymapNotify", "Expose", "GraphicsExpose", "NoExpose",
+  "VisibilityNotify", "CreateNotify", "DestroyNotify", "UnmapNotify",
+  "MapNotify", "MapRequest", "ReparentNotify", "ConfigureNotify",
+  "ConfigureRequest", "GravityNotify", "ResizeRequest",
+  "CirculateNotify", "CirculateRequest", "PropertyNotify",
+  "SelectionClear", "SelectionRequest", "SelectionNotify",
+  "ColormapNotify", "ClientMessage", "MappingNotify", "GenericEvent"
+};
+
+static char *
+get_type_name (guint32 type,
+               guint32 evtype)
+{
+  if (type == GenericEvent)
+    return g_strdup_printf ("GenericEvent/%u", evtype);
+  else if (type < G_N_ELEMENTS (core_event_names) && core_event_names[type])
+    return g_strdup (core_event_names[type]);
+  else
+    return g_strdup_printf ("extension event %u", type);
+}
+
+static TypeStats *
+lookup_stats (GArray  *stats,
+              guint32  type,
+              guint32  evtype)
+{
+  TypeStats new_stats = { 0, };
+  guint i;
+
+  for (i = 0; i < stats->len; i++)
+    {
+      TypeStats *s = &g_array_index (stats, TypeStats, i);
+
+      if (s->type == type && s->evtype == evtype)
+        return s;
+    }
+
+  new_stats.type = type;
+  new_stats.evtype = evtype;
+  g_array_append_val (stats, new_stats);
+
+  return &g_array_index (stats, TypeStats, stats->len - 1);
+}
+
+static int
+compare_stats (gconstpointer a,
+               gconstpointer b)
+{
+  const TypeStats *stats_a = a;
+  const TypeStats *stats_b = b;
+
+  if (stats_a->total_duration != stats_b->total_duration)
+    return stats_a->total_duration > stats_b->total_duration ? -1 : 1;
+
+  return 0;
+}
+
+static gboolean
+load_trace (const char *filename,
+            Trace      *trace)
+{
+  CobiwmEventTraceHeader header;
+  GError *error = NULL;
+  char *contents;
+  gsize length;
+  gsize i;
+
+  if (!g_file_get_contents (filename, &contents, &length, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      return FALSE;
+    }
+
+  if (length < sizeof (header))
+    goto invalid;
+
+  memcpy (&header, contents, sizeof (header));
+  if (memcmp (header.magic, COBIWM_EVENT_TRACE_MAGIC, sizeof (header.magic)) != 0 ||
+      header.version != COBIWM_EVENT_TRACE_VERSION ||
+      header.record_size != sizeof (CobiwmEventTraceRecord))
+    goto invalid;
+
+  /* A trailing partial record is from a session that didn't exit
+   * cleanly; ignore it.
+   */
+  trace->n_records = (length - sizeof (header)) / sizeof (CobiwmEventTraceRecord);
+  trace->records = g_new (CobiwmEventTraceRecord, MAX (trace->n_records, 1));
+  memcpy (trace->records, contents + sizeof (header),
+          trace->n_records * sizeof (CobiwmEventTraceRecord));
+  g_free (contents);
+
+  trace->stats = g_array_new (FALSE, FALSE, sizeof (TypeStats));
+  for (i = 0; i < trace->n_records; i++)
+    {
+      CobiwmEventTraceRecord *record = &trace->records[i];
+      TypeStats *stats = lookup_stats (trace->stats,
+                                       record->type, record->evtype);
+
+      stats->count++;
+      stats->total_duration += record->duration;
+      stats->max_duration = MAX (stats->max_duration, record->duration);
+      stats->total_requests += record->n_requests;
+    }
+
+  g_array_sort (trace->stats, compare_stats);
+
+  return TRUE;
+
+ invalid:
+  g_printerr ("%s is not an event trace of this version of Cobiwm\n",
+              filename);
+  g_free (contents);
+  return FALSE;
+}
+
+static void
+print_summary (Trace *trace)
+{
+  gint64 total_duration = 0;
+  gint64 elapsed = 0;
+  guint i;
+
+  g_print ("%-24s %8s %12s %10s %10s %10s\n",
+           "event", "count", "total (us)", "mean (us)", "max (us)",
+           "requests");
+
+  for (i = 0; i < trace->stats->len; i++)
+    {
+      TypeStats *stats = &g_array_index (trace->stats, TypeStats, i);
+      char *name = get_type_name (stats->type, stats->evtype);
+
+      g_print ("%-24s %8u %12" G_GINT64_FORMAT " %10.1f %10" G_GINT64_FORMAT " %10.1f\n",
+               name, stats->count, stats->total_duration,
+               (double) stats->total_duration / stats->count,
+               stats->max_duration,
+               (double) stats->total_requests / stats->count);
+      g_free (name);
+
+      total_duration += stats->total_duration;
+    }
+
+  if (trace->n_records > 0)
+    {
+      CobiwmEventTraceRecord *last = &trace->records[trace->n_records - 1];
+
+      elapsed = last->time + last->duration;
+    }
+
+  g_print ("\n%" G_GSIZE_FORMAT " events in %.3f s, %.3f s spent handling them",
+           trace->n_records, elapsed / (double) G_USEC_PER_SEC,
+           total_duration / (double) G_USEC_PER_SEC);
+  if (total_duration > 0)
+    g_print (" (%.0f events/s)",
+             trace->n_records / (total_duration / (double) G_USEC_PER_SEC));
+  g_print ("\n");
+}
+
+static int
+compare_records (gconstpointer a,
+                 gconstpointer b)
+{
+  const CobiwmEventTraceRecord *record_a = *(CobiwmEventTraceRecord **) a;
+  const CobiwmEventTraceRecord *record_b = *(CobiwmEventTraceRecord **) b;
+
+  if (record_a->duration != record_b->duration)
+    return record_a->duration > record_b->duration ? -1 : 1;
+
+  return 0;
+}
+
+static void
+print_slowest (Trace *trace,
+               guint  n)
+{
+  GPtrArray *records;
+  gsize i;
+
+  records = g_ptr_array_sized_new (trace->n_records);
+  for (i = 0; i < trace->n_records; i++)
+    g_ptr_array_add (records, &trace->records[i]);
+  g_ptr_array_sort (records, compare_records);
+
+  g_print ("%12s %-24s %12s %10s %10s\n",
+           "time (us)", "event", "window", "took (us)", "requests");
+
+  for (i = 0; i < MIN (n, records->len); i++)
+    {
+      CobiwmEventTraceRecord *record = g_ptr_array_index (records, i);
+      char *name = get_type_name (record->type, record->evtype);
+
+      g_print ("%12" G_GINT64_FORMAT " %-24s %#12lx %10" G_GINT64_FORMAT " %10u\n",
+               record->time, name, record->event.xany.window,
+               record->duration, record->n_requests);
+      g_free (name);
+    }
+
+  g_ptr_array_free (records, TRUE);
+}
+
+static void
+print_comparison (Trace *base,
+                  Trace *trace)
+{
+  guint i;
+
+  g_print ("%-24s %12s %12s %8s %12s %12s\n",
+           "event", "base (us)", "mean (us)", "change",
+           "base reqs", "requests");
+
+  for (i = 0; i < trace->stats->len; i++)
+    {
+      TypeStats *stats = &g_array_index (trace->stats, TypeStats, i);
+      TypeStats *base_stats = lookup_stats (base->stats,
+                                            stats->type, stats->evtype);
+      char *name = get_type_name (stats->type, stats->evtype);
+      double mean = (double) stats->total_duration / stats->count;
+
+      if (base_stats->count > 0)
+        {
+          double base_mean = (double) base_stats->total_duration / base_stats->count;
+
+          g_print ("%-24s %12.1f %12.1f %+7.0f%% %12.1f %12.1f\n",
+                   name, base_mean, mean,
+                   base_mean > 0 ? 100 * (mean - base_mean) / base_mean : 0,
+                   (double) base_stats->total_requests / base_stats->count,
+                   (double) stats->total_requests / stats->count);
+        }
+      else
+        {
+          g_print ("%-24s %12s %12.1f %8s %12s %12.1f\n",
+                   name, "-", mean, "-", "-",
+                   (double) stats->total_requests / stats->count);
+        }
+
+      g_free (name);
+    }
+}
+
+static void
+usage (void)
+{
+  g_printerr ("Usage: cobiwm-event-trace [--slowest N] TRACE\n"
+              "       cobiwm-event-trace --compare BASE TRACE\n");
+  exit (1);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Trace trace, base;
+
+  if (argc == 2)
+    {
+      if (!load_trace (argv[1], &trace))
+        return 1;
+
+      print_summary (&trace);
+    }
+  else if (argc == 4 && strcmp (argv[1], "--slowest") == 0)
+    {
+      if (!load_trace (argv[3], &trace))
+        return 1;
+
+      print_slowest (&trace, atoi (argv[2]));
+    }
+  else if (argc == 4 && strcmp (argv[1], "--compare") == 0)
+    {
+      if (!load_trace (argv[2], &base) ||
+          !load_trace (argv[3], &trace))
+        return 1;
+
+      print_comparison (&base, &trace);
+    }
+  else
+    usage ();
+
+  return 0;
+}
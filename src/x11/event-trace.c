@@ -0,0 +1,101 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+
+/* Recording of the X events handled by Cobiwm */
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "x11/event-trace.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#include <util.h>
+
+struct _CobiwmEventTrace
+{
+  FILE *file;
+  gint64 start_time;
+};
+
+CobiwmEventTrace *
+cobiwm_event_trace_new (const char *filename)
+{
+  CobiwmEventTrace *trace;
+  CobiwmEventTraceHeader header;
+  FILE *file;
+
+  file = g_fopen (filename, "wb");
+  if (file == NULL)
+    {
+      cobiwm_warning ("Failed to open event trace \"%s\": %s\n",
+                    filename, g_strerror (errno));
+      return NULL;
+    }
+
+  /* Events come in bursts; don't write each one out on its own */
+  setvbuf (file, NULL, _IOFBF, 64 * 1024);
+
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, COBIWM_EVENT_TRACE_MAGIC, sizeof (header.magic));
+  header.version = COBIWM_EVENT_TRACE_VERSION;
+  header.record_size = sizeof (CobiwmEventTraceRecord);
+  fwrite (&header, sizeof (header), 1, file);
+
+  trace = g_slice_new (CobiwmEventTrace);
+  trace->file = file;
+  trace->start_time = g_get_monotonic_time ();
+
+  return trace;
+}
+
+void
+cobiwm_event_trace_free (CobiwmEventTrace *trace)
+{
+  fclose (trace->file);
+  g_slice_free (CobiwmEventTrace, trace);
+}
+
+void
+cobiwm_event_trace_record (CobiwmEventTrace *trace,
+                         XEvent         *event,
+                         gint64          start_time,
+                         gint64          end_time,
+                         gulong          n_requests,
+                         gboolean        passed_on)
+{
+  CobiwmEventTraceRecord record;
+
+  memset (&record, 0, sizeof (record));
+  record.time = start_time - trace->start_time;
+  record.duration = end_time - start_time;
+  record.type = event->type;
+  record.n_requests = n_requests;
+  record.flags = passed_on ? COBIWM_EVENT_TRACE_PASSED_ON : 0;
+  record.event = *event;
+
+  if (event->type == GenericEvent)
+    {
+      record.evtype = event->xcookie.evtype;
+      record.event.xcookie.data = NULL;
+    }
+
+  fwrite (&record, sizeof (record), 1, trace->file);
+}
@@ -0,0 +1,75 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+
+/* Recording of the X events handled by Cobiwm */
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COBIWM_EVENT_TRACE_H
+#define COBIWM_EVENT_TRACE_H
+
+#include <glib.h>
+#include <X11/Xlib.h>
+
+/* Setting COBIWM_EVENT_TRACE to a file name makes Cobiwm write a record
+ * of every X event it handles to that file; cobiwm-event-trace reads
+ * them back.  The file is in native byte order: a
+ * CobiwmEventTraceHeader followed by CobiwmEventTraceRecords.
+ */
+
+#define COBIWM_EVENT_TRACE_MAGIC "CBWMEVTR"
+#define COBIWM_EVENT_TRACE_VERSION 1
+
+typedef struct
+{
+  char    magic[8];
+  guint32 version;
+  guint32 record_size;
+} CobiwmEventTraceHeader;
+
+typedef enum
+{
+  /* The event went on to GTK+ after we were done with it */
+  COBIWM_EVENT_TRACE_PASSED_ON = 1 << 0,
+} CobiwmEventTraceFlags;
+
+typedef struct
+{
+  /* Microseconds since the trace was started */
+  gint64  time;
+  /* How long handling the event took, in microseconds */
+  gint64  duration;
+  guint32 type;
+  /* The extension event type for GenericEvents, 0 otherwise */
+  guint32 evtype;
+  /* The number of X requests we made while handling it */
+  guint32 n_requests;
+  guint32 flags;
+  /* The event as we got it; the data of GenericEvents is not kept */
+  XEvent  event;
+} CobiwmEventTraceRecord;
+
+typedef struct _CobiwmEventTrace CobiwmEventTrace;
+
+CobiwmEventTrace *cobiwm_event_trace_new    (const char       *filename);
+void            cobiwm_event_trace_free   (CobiwmEventTrace   *trace);
+void            cobiwm_event_trace_record (CobiwmEventTrace   *trace,
+                                         XEvent           *event,
+                                         gint64            start_time,
+                                         gint64            end_time,
+                                         gulong            n_requests,
+                                         gboolean          passed_on);
+
+#endif /* COBIWM_EVENT_TRACE_H */
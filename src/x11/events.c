@@ -23,6 +23,8 @@
 #include "config.h"
 #include "x11/events.h"
 
+#include <string.h>
+
 #include <X11/Xatom.h>
 #include <X11/extensions/Xdamage.h>
 #include <X11/extensions/shape.h>
@@ -34,6 +36,8 @@
 #include "workspace-private.h"
 
 #include "x11/window-x11.h"
+#include "x11/window-props.h"
+#include "x11/event-trace.h"
 #include "x11/xprops.h"
 
 #ifdef HAVE_WAYLAND
@@ -42,6 +46,18 @@
 #include "wayland/cobiwm-xwayland-private.h"
 #endif
 
+/* The parts of cobiwm_display_handle_xevent() an event goes through */
+typedef enum
+{
+  COBIWM_EVENT_DISPATCH_STARTUP_NOTIFICATION = 1 << 0,
+  COBIWM_EVENT_DISPATCH_XWAYLAND_SELECTION   = 1 << 1,
+  /* Focus tracking, the root window, input and window management */
+  COBIWM_EVENT_DISPATCH_CORE                 = 1 << 2,
+  COBIWM_EVENT_DISPATCH_COMPOSITOR           = 1 << 3,
+
+  COBIWM_EVENT_DISPATCH_ALL                  = 0x0f
+} CobiwmEventDispatch;
+
 static XIEvent *
 get_input_event (CobiwmDisplay *display,
                  XEvent      *event)
@@ -863,6 +879,9 @@ handle_input_xevent (CobiwmDisplay  *display,
   switch (input_event->evtype)
     {
     case XI_Enter:
+      if (window && enter_event->detail != XINotifyInferior)
+        cobiwm_display_update_lazy_button_grabs (display, window);
+
       if (display->event_route != COBIWM_EVENT_ROUTE_NORMAL)
         break;
 
@@ -1686,15 +1705,19 @@ static gboolean
 cobiwm_display_handle_xevent (CobiwmDisplay *display,
                             XEvent      *event)
 {
-  Window modified;
+  Window modified = None;
   gboolean bypass_compositor = FALSE, bypass_gtk = FALSE;
   XIEvent *input_event;
+  guint8 dispatch;
 
 #if 0
   cobiwm_spew_event_print (display, event);
 #endif
 
-  if (cobiwm_startup_notification_handle_xevent (display->startup_notification,
+  dispatch = display->event_dispatch[event->type & 0x7f];
+
+  if ((dispatch & COBIWM_EVENT_DISPATCH_STARTUP_NOTIFICATION) &&
+      cobiwm_startup_notification_handle_xevent (display->startup_notification,
                                                event))
     {
       bypass_gtk = bypass_compositor = TRUE;
@@ -1702,7 +1725,8 @@ cobiwm_display_handle_xevent (CobiwmDisplay *display,
     }
 
 #ifdef HAVE_WAYLAND
-  if (cobiwm_is_wayland_compositor () &&
+  if ((dispatch & COBIWM_EVENT_DISPATCH_XWAYLAND_SELECTION) &&
+      cobiwm_is_wayland_compositor () &&
       cobiwm_xwayland_selection_handle_event (event))
     {
       bypass_gtk = bypass_compositor = TRUE;
@@ -1710,9 +1734,27 @@ cobiwm_display_handle_xevent (CobiwmDisplay *display,
     }
 #endif
 
+  if (!(dispatch & COBIWM_EVENT_DISPATCH_CORE))
+    {
+      display->monitor_cache_invalidated = TRUE;
+      goto out;
+    }
+
+  /* Property changes are only queued, so that a run of PropertyNotify
+   * events can be fetched in one go; anything else may depend on their
+   * values, so catch up first.
+   */
+  if (event->type != PropertyNotify)
+    cobiwm_display_flush_property_reloads (display);
+
   display->current_time = event_get_time (display, event);
   display->monitor_cache_invalidated = TRUE;
 
+  /* Selection events carry the timestamps of the clients sending them */
+  if (!event->xany.send_event &&
+      (event->type == PropertyNotify || event->type == GenericEvent))
+    cobiwm_display_note_server_time (display, display->current_time);
+
   if (display->focused_by_us &&
       event->xany.serial > display->focus_serial &&
       display->focus_window &&
@@ -1785,7 +1827,8 @@ cobiwm_display_handle_xevent (CobiwmDisplay *display,
     }
 
  out:
-  if (!bypass_compositor)
+  if (!bypass_compositor &&
+      (dispatch & COBIWM_EVENT_DISPATCH_COMPOSITOR))
     {
       CobiwmWindow *window = modified != None ? cobiwm_display_lookup_x_window (display, modified) : NULL;
 
@@ -1804,16 +1847,77 @@ xevent_filter (GdkXEvent *xevent,
                gpointer   data)
 {
   CobiwmDisplay *display = data;
+  gboolean handled;
+
+  if (display->event_trace)
+    {
+      CobiwmEventTrace *trace = display->event_trace;
+      XEvent event_copy = *(XEvent *) xevent;
+      gulong first_request = NextRequest (display->xdisplay);
+      gint64 start_time = g_get_monotonic_time ();
+
+      handled = cobiwm_display_handle_xevent (display, xevent);
+
+      /* Handling a SelectionClear can close the display, and the
+       * trace with it.
+       */
+      if (cobiwm_get_display () == display)
+        cobiwm_event_trace_record (trace, &event_copy,
+                                 start_time, g_get_monotonic_time (),
+                                 NextRequest (display->xdisplay) - first_request,
+                                 !handled);
+    }
+  else
+    handled = cobiwm_display_handle_xevent (display, xevent);
 
-  if (cobiwm_display_handle_xevent (display, xevent))
+  if (handled)
     return GDK_FILTER_REMOVE;
   else
     return GDK_FILTER_CONTINUE;
 }
 
+/**
+ * cobiwm_display_init_event_dispatch_x11:
+ * @display: The display
+ *
+ * Works out which parts of cobiwm_display_handle_xevent() each type of
+ * event needs to go through.  Has to be called once the extensions
+ * have been queried, since their event types aren't known before.
+ */
+void
+cobiwm_display_init_event_dispatch_x11 (CobiwmDisplay *display)
+{
+  /* Only the extension events we get a lot of are singled out */
+  const guint8 extension_dispatch =
+    COBIWM_EVENT_DISPATCH_CORE | COBIWM_EVENT_DISPATCH_COMPOSITOR;
+
+  memset (display->event_dispatch, COBIWM_EVENT_DISPATCH_ALL,
+          sizeof (display->event_dispatch));
+
+  /* Damage is all the compositor's; there is nothing in the core code
+   * for it to do, or to be up to date for it.
+   */
+  if (COBIWM_DISPLAY_HAS_DAMAGE (display))
+    display->event_dispatch[display->damage_event_base + XDamageNotify] =
+      COBIWM_EVENT_DISPATCH_COMPOSITOR;
+
+  if (COBIWM_DISPLAY_HAS_XSYNC (display))
+    display->event_dispatch[display->xsync_event_base + XSyncAlarmNotify] =
+      extension_dispatch;
+
+  if (COBIWM_DISPLAY_HAS_SHAPE (display))
+    display->event_dispatch[display->shape_event_base + ShapeNotify] =
+      extension_dispatch;
+}
+
 void
 cobiwm_display_init_events_x11 (CobiwmDisplay *display)
 {
+  const char *trace_filename = g_getenv ("COBIWM_EVENT_TRACE");
+
+  if (trace_filename)
+    display->event_trace = cobiwm_event_trace_new (trace_filename);
+
   gdk_window_add_filter (NULL, xevent_filter, display);
 }
 
@@ -1821,4 +1925,6 @@ void
 cobiwm_display_free_events_x11 (CobiwmDisplay *display)
 {
   gdk_window_remove_filter (NULL, xevent_filter, display);
+
+  g_clear_pointer (&display->event_trace, cobiwm_event_trace_free);
 }
@@ -26,6 +26,7 @@
 #define COBIWM_EVENTS_X11_H
 
 void cobiwm_display_init_events_x11 (CobiwmDisplay *display);
+void cobiwm_display_init_event_dispatch_x11 (CobiwmDisplay *display);
 void cobiwm_display_free_events_x11 (CobiwmDisplay *display);
 
 #endif
@@ -24,6 +24,7 @@
 #include "iconcache.h"
 
 #include <errors.h>
+#include <string.h>
 
 #include <cairo.h>
 #include <cairo-xlib.h>
@@ -32,85 +33,74 @@
 #include <X11/Xatom.h>
 #include <X11/extensions/Xrender.h>
 
-static gboolean
-find_largest_sizes (gulong *data,
-                    gulong  nitems,
-                    int    *width,
-                    int    *height)
+/* One of the images in a _NET_WM_ICON property; @offset is where its
+ * pixels start, in 32-bit items from the start of the property.
+ */
+typedef struct
+{
+  int width;
+  int height;
+  gulong offset;
+} IconSize;
+
+/* _NET_WM_ICON can hold many sizes of the same icon, so it can be very
+ * large; only read this much of it in one go, and fetch the headers and
+ * the pixels of the images we end up using separately if it's longer.
+ * This is enough for the 16x16, 32x32 and 48x48 sizes most
+ * clients put first.  Headers past it are read in windows of the same
+ * size, so the smaller images following a large one cost one request
+ * between them.
+ */
+#define ICON_INITIAL_FETCH_LONGS 4096
+
+static void
+find_largest_sizes (const IconSize *sizes,
+                    int             n_sizes,
+                    int            *width,
+                    int            *height)
 {
+  int i;
+
   *width = 0;
   *height = 0;
 
-  while (nitems > 0)
+  for (i = 0; i < n_sizes; i++)
     {
-      int w, h;
-
-      if (nitems < 3)
-        return FALSE; /* no space for w, h */
-
-      w = data[0];
-      h = data[1];
-
-      if (nitems < ((gulong)(w * h) + 2))
-        return FALSE; /* not enough data */
-
-      *width = MAX (w, *width);
-      *height = MAX (h, *height);
-
-      data += (w * h) + 2;
-      nitems -= (w * h) + 2;
+      *width = MAX (sizes[i].width, *width);
+      *height = MAX (sizes[i].height, *height);
     }
-
-  return TRUE;
 }
 
-static gboolean
-find_best_size (gulong  *data,
-                gulong   nitems,
-                int      ideal_width,
-                int      ideal_height,
-                int     *width,
-                int     *height,
-                gulong **start)
+static const IconSize *
+find_best_size (const IconSize *sizes,
+                int             n_sizes,
+                int             ideal_width,
+                int             ideal_height)
 {
-  int best_w;
-  int best_h;
-  gulong *best_start;
+  const IconSize *best;
   int max_width, max_height;
+  int i;
 
-  *width = 0;
-  *height = 0;
-  *start = NULL;
-
-  if (!find_largest_sizes (data, nitems, &max_width, &max_height))
-    return FALSE;
+  find_largest_sizes (sizes, n_sizes, &max_width, &max_height);
 
   if (ideal_width < 0)
     ideal_width = max_width;
   if (ideal_height < 0)
     ideal_height = max_height;
 
-  best_w = 0;
-  best_h = 0;
-  best_start = NULL;
+  best = NULL;
 
-  while (nitems > 0)
+  for (i = 0; i < n_sizes; i++)
     {
       int w, h;
       gboolean replace;
 
       replace = FALSE;
 
-      if (nitems < 3)
-        return FALSE; /* no space for w, h */
-
-      w = data[0];
-      h = data[1];
+      w = sizes[i].width;
+      h = sizes[i].height;
 
-      if (nitems < ((gulong)(w * h) + 2))
-        break; /* not enough data */
-
-      if (best_start == NULL)
+      if (best == NULL)
         {
           replace = TRUE;
         }
@@ -118,7 +108,7 @@ find_best_size (gulong  *data,
         {
           /* work with averages */
           const int ideal_size = (ideal_width + ideal_height) / 2;
-          int best_size = (best_w + best_h) / 2;
+          int best_size = (best->width + best->height) / 2;
           int this_size = (w + h) / 2;
 
           /* larger than desired is always better than smaller */
@@ -139,121 +129,496 @@ find_best_size (gulong  *data,
         }
 
       if (replace)
+        best = &sizes[i];
+    }
+
+  return best;
+}
+
+/* Icons read from _NET_WM_ICON are shared between all the windows which
+ * have the same pixels at the same size, e.g. all the windows of one
+ * application.  The table doesn't hold a reference on the surfaces; an
+ * entry goes away when the last window using it drops its surface.
+ */
+typedef struct
+{
+  guint hash;
+  int width;
+  int height;
+  guint32 *pixels;
+  cairo_surface_t *surface;
+} SharedIcon;
+
+static GHashTable *shared_icons = NULL;
+static const cairo_user_data_key_t shared_icon_key;
+
+static guint
+shared_icon_hash (gconstpointer key)
+{
+  const SharedIcon *icon = key;
+
+  return icon->hash;
+}
+
+static gboolean
+shared_icon_equal (gconstpointer a,
+                   gconstpointer b)
+{
+  const SharedIcon *icon_a = a;
+  const SharedIcon *icon_b = b;
+
+  if (icon_a == icon_b)
+    return TRUE;
+
+  return icon_a->hash == icon_b->hash &&
+         icon_a->width == icon_b->width &&
+         icon_a->height == icon_b->height &&
+         memcmp (icon_a->pixels, icon_b->pixels,
+                 (gsize) icon_a->width * icon_a->height * sizeof (guint32)) == 0;
+}
+
+static void
+shared_icon_free (gpointer data)
+{
+  SharedIcon *icon = data;
+
+  g_hash_table_remove (shared_icons, icon);
+  g_free (icon->pixels);
+  g_slice_free (SharedIcon, icon);
+}
+
+/* (c * a) / 255, rounded, without a division */
+static inline guint32
+mul_un8 (guint32 c,
+         guint32 a)
+{
+  guint32 t = c * a + 0x80;
+
+  return ((t >> 8) + t) >> 8;
+}
+
+/* _NET_WM_ICON has one non-premultiplied pixel per long, which is wider
+ * than a pixel on 64-bit systems, while cairo wants packed premultiplied
+ * pixels.  Kept free of branches and calls so that the compiler can
+ * vectorize it.
+ */
+static void
+premultiply_and_pack (const gulong *argb_data,
+                      guint32      *pixels,
+                      gsize         n_pixels)
+{
+  gsize i;
+
+  for (i = 0; i < n_pixels; i++)
+    {
+      guint32 p = argb_data[i];
+      guint32 a = p >> 24;
+
+      pixels[i] = (a << 24) |
+                  (mul_un8 ((p >> 16) & 0xff, a) << 16) |
+                  (mul_un8 ((p >> 8) & 0xff, a) << 8) |
+                  mul_un8 (p & 0xff, a);
+    }
+}
+
+/* Averages the premultiplied @src over the boxes of it that each pixel
+ * of the smaller @dst covers.
+ */
+static void
+box_downscale (const guint32 *src,
+               int            src_width,
+               int            src_height,
+               guint32       *dst,
+               int            dst_width,
+               int            dst_height)
+{
+  int dx, dy, x, y;
+
+  for (dy = 0; dy < dst_height; dy++)
+    {
+      int y0 = (gint64) dy * src_height / dst_height;
+      int y1 = (gint64) (dy + 1) * src_height / dst_height;
+
+      for (dx = 0; dx < dst_width; dx++)
         {
-          best_start = data + 2;
-          best_w = w;
-          best_h = h;
-        }
+          int x0 = (gint64) dx * src_width / dst_width;
+          int x1 = (gint64) (dx + 1) * src_width / dst_width;
+          guint64 a = 0, r = 0, g = 0, b = 0;
+          guint64 n = (guint64) (x1 - x0) * (y1 - y0);
+
+          for (y = y0; y < y1; y++)
+            {
+              const guint32 *row = src + (gsize) y * src_width;
+
+              for (x = x0; x < x1; x++)
+                {
+                  a += row[x] >> 24;
+                  r += (row[x] >> 16) & 0xff;
+                  g += (row[x] >> 8) & 0xff;
+                  b += row[x] & 0xff;
+                }
+            }
 
-      data += (w * h) + 2;
-      nitems -= (w * h) + 2;
+          dst[(gsize) dy * dst_width + dx] =
+            ((guint32) ((a + n / 2) / n) << 24) |
+            ((guint32) ((r + n / 2) / n) << 16) |
+            ((guint32) ((g + n / 2) / n) << 8) |
+            (guint32) ((b + n / 2) / n);
+        }
     }
+}
 
-  if (best_start)
+/* The size to show a @width by @height image at, if we want it to be
+ * at most @ideal_width by @ideal_height; images are never scaled up.
+ * Returns FALSE for an empty image, which box_downscale() can't handle.
+ */
+static gboolean
+get_scaled_size (int  width,
+                 int  height,
+                 int  ideal_width,
+                 int  ideal_height,
+                 int *scaled_width,
+                 int *scaled_height)
+{
+  if (width <= 0 || height <= 0)
+    return FALSE;
+
+  *scaled_width = width;
+  *scaled_height = height;
+
+  if (ideal_width <= 0 || ideal_height <= 0 ||
+      (width <= ideal_width && height <= ideal_height))
+    return TRUE;
+
+  if ((gint64) width * ideal_height > (gint64) height * ideal_width)
     {
-      *start = best_start;
-      *width = best_w;
-      *height = best_h;
-      return TRUE;
+      *scaled_width = ideal_width;
+      *scaled_height = MAX (1, (gint64) height * ideal_width / width);
     }
   else
-    return FALSE;
+    {
+      *scaled_height = ideal_height;
+      *scaled_width = MAX (1, (gint64) width * ideal_height / height);
+    }
+
+  return TRUE;
 }
 
+/* Makes a surface of at most @ideal_width by @ideal_height out of the
+ * premultiplied @pixels, shared with any other window showing the
+ * same thing; %NULL if the image is empty.
+ */
 static cairo_surface_t *
-argbdata_to_surface (gulong *argb_data, int w, int h)
+icon_surface_for_size (const guint32 *pixels,
+                       int            w,
+                       int            h,
+                       int            ideal_width,
+                       int            ideal_height)
 {
-  cairo_surface_t *surface;
-  int y, x, stride;
-  uint32_t *data;
+  SharedIcon lookup;
+  SharedIcon *icon;
+  gsize i, n_pixels;
+  guint hash;
+
+  if (!get_scaled_size (w, h, ideal_width, ideal_height,
+                        &lookup.width, &lookup.height))
+    return NULL;
 
-  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, w, h);
-  stride = cairo_image_surface_get_stride (surface) / sizeof (uint32_t);
-  data = (uint32_t *) cairo_image_surface_get_data (surface);
+  n_pixels = (gsize) lookup.width * lookup.height;
+  lookup.pixels = g_new (guint32, MAX (n_pixels, 1));
 
-  /* One could speed this up a lot. */
-  for (y = 0; y < h; y++)
+  if (lookup.width == w && lookup.height == h)
+    memcpy (lookup.pixels, pixels, n_pixels * sizeof (guint32));
+  else
+    box_downscale (pixels, w, h,
+                   lookup.pixels, lookup.width, lookup.height);
+
+  /* FNV-1a */
+  hash = 2166136261u;
+  for (i = 0; i < n_pixels; i++)
+    hash = (hash ^ lookup.pixels[i]) * 16777619u;
+  lookup.hash = hash;
+
+  if (shared_icons == NULL)
+    shared_icons = g_hash_table_new (shared_icon_hash, shared_icon_equal);
+
+  icon = g_hash_table_lookup (shared_icons, &lookup);
+  if (icon)
     {
-      for (x = 0; x < w; x++)
-        {
-          uint32_t *p = &data[y * stride + x];
-          gulong *d = &argb_data[y * w + x];
-          *p = *d;
-        }
+      g_free (lookup.pixels);
+      return cairo_surface_reference (icon->surface);
     }
 
-  cairo_surface_mark_dirty (surface);
+  icon = g_slice_new (SharedIcon);
+  *icon = lookup;
+  icon->surface =
+    cairo_image_surface_create_for_data ((unsigned char *) icon->pixels,
+                                         CAIRO_FORMAT_ARGB32,
+                                         icon->width, icon->height,
+                                         icon->width * sizeof (guint32));
+  cairo_surface_set_user_data (icon->surface, &shared_icon_key,
+                               icon, shared_icon_free);
+
+  g_hash_table_add (shared_icons, icon);
 
-  return surface;
+  return icon->surface;
 }
 
+/* Reads @length items of _NET_WM_ICON from @offset; the caller has to
+ * hold an error trap.
+ */
 static gboolean
-read_rgb_icon (CobiwmDisplay      *display,
-               Window            xwindow,
-               int               ideal_width,
-               int               ideal_height,
-               int               ideal_mini_width,
-               int               ideal_mini_height,
-               cairo_surface_t **icon,
-               cairo_surface_t **mini_icon)
+get_icon_property_slice (CobiwmDisplay *display,
+                         Window       xwindow,
+                         gulong       offset,
+                         gulong       length,
+                         gulong     **data,
+                         gulong      *nitems,
+                         gulong      *bytes_after)
 {
   Atom type;
   int format;
-  gulong nitems;
-  gulong bytes_after;
-  int result, err;
-  guchar *data;
-  gulong *best;
-  int w, h;
-  gulong *best_mini;
-  int mini_w, mini_h;
-  gulong *data_as_long;
+  int result;
+  guchar *prop_data;
 
-  cobiwm_error_trap_push (display);
   type = None;
-  data = NULL;
+  prop_data = NULL;
   result = XGetWindowProperty (display->xdisplay,
 			       xwindow,
                                display->atom__NET_WM_ICON,
-			       0, G_MAXLONG,
-			       False, XA_CARDINAL, &type, &format, &nitems,
-			       &bytes_after, &data);
-  err = cobiwm_error_trap_pop_with_return (display);
+			       offset, length,
+			       False, XA_CARDINAL, &type, &format, nitems,
+			       bytes_after, &prop_data);
 
-  if (err != Success ||
-      result != Success)
+  if (result != Success)
     return FALSE;
 
-  if (type != XA_CARDINAL)
+  if (type != XA_CARDINAL || format != 32)
     {
-      XFree (data);
+      XFree (prop_data);
       return FALSE;
     }
 
-  data_as_long = (gulong *)data;
+  *data = (gulong *)prop_data;
+
+  return TRUE;
+}
+
+/* Returns the premultiplied pixels of @size, converted from @data if
+ * they are in the part of the property which we already have, or read
+ * from the server.
+ */
+static guint32 *
+read_icon_pixels (CobiwmDisplay    *display,
+                  Window          xwindow,
+                  gulong         *data,
+                  gulong          nitems,
+                  const IconSize *size)
+{
+  gulong n_pixels = (gulong) size->width * size->height;
+  guint32 *pixels;
+  gulong *argb_data;
+  gulong n_read, bytes_after;
 
-  if (!find_best_size (data_as_long, nitems,
-                       ideal_width, ideal_height,
-                       &w, &h, &best))
+  if (size->offset + n_pixels <= nitems)
     {
-      XFree (data);
-      return FALSE;
+      pixels = g_new (guint32, MAX (n_pixels, 1));
+      premultiply_and_pack (data + size->offset, pixels, n_pixels);
+      return pixels;
     }
 
-  if (!find_best_size (data_as_long, nitems,
-                       ideal_mini_width, ideal_mini_height,
-                       &mini_w, &mini_h, &best_mini))
+  if (!get_icon_property_slice (display, xwindow,
+                                size->offset, n_pixels,
+                                &argb_data, &n_read, &bytes_after))
+    return NULL;
+
+  if (n_read < n_pixels)
     {
-      XFree (data);
-      return FALSE;
+      /* Changed under us */
+      XFree (argb_data);
+      return NULL;
     }
 
-  *icon = argbdata_to_surface (best, w, h);
-  *mini_icon = argbdata_to_surface (best_mini, mini_w, mini_h);
+  pixels = g_new (guint32, MAX (n_pixels, 1));
+  premultiply_and_pack (argb_data, pixels, n_pixels);
+  XFree (argb_data);
+
+  return pixels;
+}
+
+static gboolean
+read_rgb_icon_untrapped (CobiwmDisplay      *display,
+                         Window            xwindow,
+                         int               ideal_width,
+                         int               ideal_height,
+                         int               ideal_mini_width,
+                         int               ideal_mini_height,
+                         cairo_surface_t **icon,
+                         cairo_surface_t **mini_icon)
+{
+  gulong nitems;
+  gulong bytes_after;
+  gulong *data;
+  gulong *header_data;
+  gulong header_start, header_nitems;
+  gulong total, pos;
+  GArray *sizes;
+  const IconSize *best;
+  const IconSize *best_mini;
+  guint32 *pixels;
+  guint32 *mini_pixels;
+  gboolean ret;
+
+  if (!get_icon_property_slice (display, xwindow,
+                                0, ICON_INITIAL_FETCH_LONGS,
+                                &data, &nitems, &bytes_after))
+    return FALSE;
+
+  total = nitems + bytes_after / 4;
+  sizes = g_array_new (FALSE, FALSE, sizeof (IconSize));
+  header_data = NULL;
+  header_start = header_nitems = 0;
+  ret = FALSE;
+
+  /* Collect the sizes on offer, skipping over their pixels and reading
+   * the headers past what we have a window at a time.
+   */
+  pos = 0;
+  while (pos < total)
+    {
+      IconSize size;
+      gulong n_pixels;
+
+      if (total - pos < 3)
+        goto out; /* no space for w, h */
 
+      if (pos + 2 <= nitems)
+        {
+          size.width = data[pos];
+          size.height = data[pos + 1];
+        }
+      else
+        {
+          if (header_data == NULL ||
+              pos + 2 > header_start + header_nitems)
+            {
+              gulong header_bytes_after;
+
+              if (header_data)
+                XFree (header_data);
+              header_data = NULL;
+
+              if (!get_icon_property_slice (display, xwindow,
+                                            pos, ICON_INITIAL_FETCH_LONGS,
+                                            &header_data, &header_nitems,
+                                            &header_bytes_after))
+                goto out;
+
+              header_start = pos;
+              if (header_nitems < 2)
+                goto out; /* changed under us */
+            }
+
+          size.width = header_data[pos - header_start];
+          size.height = header_data[pos - header_start + 1];
+        }
+
+      if (size.width < 0 || size.height < 0)
+        goto out;
+
+      /* Nothing to show, and nothing to scale down from */
+      if (size.width == 0 || size.height == 0)
+        {
+          pos += (gulong) size.width * size.height + 2;
+          continue;
+        }
+
+      n_pixels = (gulong) size.width * size.height;
+      if (total - pos - 2 < n_pixels)
+        goto out; /* not enough data */
+
+      size.offset = pos + 2;
+      g_array_append_val (sizes, size);
+
+      pos += n_pixels + 2;
+    }
+
+  if (sizes->len == 0)
+    goto out;
+
+  best = find_best_size ((IconSize *) sizes->data, sizes->len,
+                         ideal_width, ideal_height);
+  best_mini = find_best_size ((IconSize *) sizes->data, sizes->len,
+                              ideal_mini_width, ideal_mini_height);
+
+  /* Often both come from the same image, e.g. when there is only a
+   * large one; convert it once and scale it down to both sizes.
+   */
+  pixels = read_icon_pixels (display, xwindow, data, nitems, best);
+  if (best_mini == best)
+    mini_pixels = pixels;
+  else
+    mini_pixels = read_icon_pixels (display, xwindow, data, nitems, best_mini);
+
+  if (pixels && mini_pixels)
+    {
+      *icon = icon_surface_for_size (pixels, best->width, best->height,
+                                     ideal_width, ideal_height);
+      *mini_icon = icon_surface_for_size (mini_pixels,
+                                          best_mini->width, best_mini->height,
+                                          ideal_mini_width, ideal_mini_height);
+      ret = *icon != NULL && *mini_icon != NULL;
+      if (!ret)
+        {
+          g_clear_pointer (icon, cairo_surface_destroy);
+          g_clear_pointer (mini_icon, cairo_surface_destroy);
+        }
+    }
+
+  if (mini_pixels != pixels)
+    g_free (mini_pixels);
+  g_free (pixels);
+
+ out:
+  g_array_free (sizes, TRUE);
+  if (header_data)
+    XFree (header_data);
   XFree (data);
 
-  return TRUE;
+  return ret;
+}
+
+/* Reading the icon takes several requests; check for errors, e.g. from
+ * the window having gone away, once at the end instead of after each.
+ */
+static gboolean
+read_rgb_icon (CobiwmDisplay      *display,
+               Window            xwindow,
+               int               ideal_width,
+               int               ideal_height,
+               int               ideal_mini_width,
+               int               ideal_mini_height,
+               cairo_surface_t **icon,
+               cairo_surface_t **mini_icon)
+{
+  gboolean ret;
+  int err;
+
+  cobiwm_error_trap_push (display);
+  ret = read_rgb_icon_untrapped (display, xwindow,
+                                 ideal_width, ideal_height,
+                                 ideal_mini_width, ideal_mini_height,
+                                 icon, mini_icon);
+  err = cobiwm_error_trap_pop_with_return (display);
+
+  if (ret && err != Success)
+    {
+      g_clear_pointer (icon, cairo_surface_destroy);
+      g_clear_pointer (mini_icon, cairo_surface_destroy);
+      ret = FALSE;
+    }
+
+  return ret;
 }
 
 static void
@@ -75,6 +75,9 @@ struct _CobiwmWindowPropHooks
   CobiwmPropHookFlags flags;
 };
 
+static void init_prop_value_for_window (gboolean             override_redirect,
+                                        CobiwmWindowPropHooks *hooks,
+                                        CobiwmPropValue       *value);
 static void init_prop_value            (CobiwmWindow          *window,
                                         CobiwmWindowPropHooks *hooks,
                                         CobiwmPropValue       *value);
@@ -124,29 +127,258 @@ cobiwm_window_reload_property (CobiwmWindow      *window,
                                             initial);
 }
 
+/* A property change seen in a PropertyNotify which we haven't reloaded
+ * yet, see cobiwm_window_queue_property_reload()
+ */
+typedef struct
+{
+  CobiwmWindow *window;
+  Window      xwindow;
+  Atom        property;
+} PendingReload;
+
+/* Past this many queued reloads, fetch them right away anyway */
+#define MAX_PENDING_RELOADS 64
+
+static gboolean
+flush_property_reloads_idle (gpointer data)
+{
+  CobiwmDisplay *display = data;
+
+  display->property_reload_idle_id = 0;
+  cobiwm_display_flush_property_reloads (display);
+
+  return G_SOURCE_REMOVE;
+}
+
 void
-cobiwm_window_load_initial_properties (CobiwmWindow *window)
+cobiwm_window_queue_property_reload (CobiwmWindow *window,
+                                   Window      xwindow,
+                                   Atom        property)
 {
-  int i, j;
+  CobiwmDisplay *display = window->display;
+  CobiwmWindowPropHooks *hooks;
+  PendingReload reload;
+  guint i;
+
+  hooks = find_hooks (display, property);
+  if (!hooks || (hooks->flags & INIT_ONLY))
+    return;
+
+  if (display->pending_property_reloads == NULL)
+    display->pending_property_reloads =
+      g_array_new (FALSE, FALSE, sizeof (PendingReload));
+
+  /* A client changing the same property over and over only needs it
+   * fetched once.
+   */
+  for (i = 0; i < display->pending_property_reloads->len; i++)
+    {
+      PendingReload *pending = &g_array_index (display->pending_property_reloads,
+                                               PendingReload, i);
+      if (pending->window == window &&
+          pending->xwindow == xwindow &&
+          pending->property == property)
+        return;
+    }
+
+  reload.window = window;
+  reload.xwindow = xwindow;
+  reload.property = property;
+  g_array_append_val (display->pending_property_reloads, reload);
+
+  if (display->pending_property_reloads->len >= MAX_PENDING_RELOADS)
+    cobiwm_display_flush_property_reloads (display);
+  else if (display->property_reload_idle_id == 0)
+    {
+      /* Runs once the current batch of X events has been handled, but
+       * before anything is redrawn.
+       */
+      display->property_reload_idle_id =
+        g_idle_add_full (G_PRIORITY_HIGH_IDLE, flush_property_reloads_idle,
+                         display, NULL);
+      g_source_set_name_by_id (display->property_reload_idle_id,
+                               "[cobiwm] flush_property_reloads_idle");
+    }
+}
+
+/* The window may have been unmanaged since the PropertyNotify came in,
+ * or by the reload of an earlier property.
+ */
+static gboolean
+pending_reload_is_valid (CobiwmDisplay   *display,
+                         PendingReload *pending)
+{
+  return cobiwm_display_lookup_x_window (display,
+                                       pending->xwindow) == pending->window;
+}
+
+void
+cobiwm_display_flush_property_reloads (CobiwmDisplay *display)
+{
+  GArray *pending;
   CobiwmPropValue *values;
-  int n_properties = 0;
+  CobiwmPropRequest **requests;
+  guint i;
+
+  if (display->property_reload_idle_id)
+    {
+      g_source_remove (display->property_reload_idle_id);
+      display->property_reload_idle_id = 0;
+    }
+
+  pending = display->pending_property_reloads;
+  if (pending == NULL || pending->len == 0)
+    return;
 
-  values = g_new0 (CobiwmPropValue, window->display->n_prop_hooks);
+  /* Reload hooks can cause more PropertyNotify handling; those go into
+   * a new batch.
+   */
+  display->pending_property_reloads = NULL;
+
+  values = g_new0 (CobiwmPropValue, pending->len);
+  requests = g_new0 (CobiwmPropRequest *, pending->len);
+
+  /* Send all the requests before waiting for any of the replies */
+  for (i = 0; i < pending->len; i++)
+    {
+      PendingReload *reload = &g_array_index (pending, PendingReload, i);
+
+      if (!pending_reload_is_valid (display, reload))
+        continue;
+
+      init_prop_value (reload->window,
+                       find_hooks (display, reload->property),
+                       &values[i]);
+      requests[i] = cobiwm_prop_request_values (display, reload->xwindow,
+                                              &values[i], 1);
+    }
+
+  for (i = 0; i < pending->len; i++)
+    {
+      PendingReload *reload = &g_array_index (pending, PendingReload, i);
+
+      if (requests[i] == NULL)
+        continue;
+
+      cobiwm_prop_finish_values (requests[i]);
+
+      if (pending_reload_is_valid (display, reload))
+        reload_prop_value (reload->window,
+                           find_hooks (display, reload->property),
+                           &values[i],
+                           FALSE);
+    }
+
+  cobiwm_prop_free_values (values, pending->len);
+  g_free (values);
+  g_free (requests);
+  g_array_free (pending, TRUE);
+}
+
+/* The initial properties of a window, possibly requested before the
+ * window is created; see cobiwm_window_prefetch_initial_properties()
+ */
+struct CobiwmInitialProperties
+{
+  Window             xwindow;
+  gboolean           override_redirect;
+  CobiwmPropValue     *values;
+  int                n_values;
+  CobiwmPropRequest   *request;
+};
+
+static CobiwmInitialProperties *
+request_initial_properties (CobiwmDisplay *display,
+                            Window       xwindow,
+                            gboolean     override_redirect)
+{
+  CobiwmInitialProperties *props;
+  int i, j;
+
+  props = g_new0 (CobiwmInitialProperties, 1);
+  props->xwindow = xwindow;
+  props->override_redirect = override_redirect;
+  props->values = g_new0 (CobiwmPropValue, display->n_prop_hooks);
 
   j = 0;
-  for (i = 0; i < window->display->n_prop_hooks; i++)
+  for (i = 0; i < display->n_prop_hooks; i++)
     {
-      CobiwmWindowPropHooks *hooks = &window->display->prop_hooks_table[i];
+      CobiwmWindowPropHooks *hooks = &display->prop_hooks_table[i];
       if (hooks->flags & LOAD_INIT)
         {
-          init_prop_value (window, hooks, &values[j]);
+          init_prop_value_for_window (override_redirect, hooks,
+                                      &props->values[j]);
           ++j;
         }
     }
-  n_properties = j;
+  props->n_values = j;
+
+  props->request = cobiwm_prop_request_values (display, xwindow,
+                                             props->values, props->n_values);
+
+  return props;
+}
+
+static void
+free_initial_properties (CobiwmInitialProperties *props)
+{
+  /* The replies have to be collected even if nobody wants them */
+  if (props->request)
+    cobiwm_prop_finish_values (props->request);
+
+  cobiwm_prop_free_values (props->values, props->n_values);
+  g_free (props->values);
+  g_free (props);
+}
+
+void
+cobiwm_window_prefetch_initial_properties (CobiwmDisplay *display,
+                                         Window       xwindow,
+                                         gboolean     override_redirect)
+{
+  cobiwm_window_discard_prefetched_properties (display);
+
+  display->prefetched_initial_properties =
+    request_initial_properties (display, xwindow, override_redirect);
+}
+
+void
+cobiwm_window_discard_prefetched_properties (CobiwmDisplay *display)
+{
+  if (display->prefetched_initial_properties == NULL)
+    return;
+
+  free_initial_properties (display->prefetched_initial_properties);
+  display->prefetched_initial_properties = NULL;
+}
+
+void
+cobiwm_window_load_initial_properties (CobiwmWindow *window)
+{
+  CobiwmDisplay *display = window->display;
+  CobiwmInitialProperties *props;
+  CobiwmPropValue *values;
+  int i, j;
+
+  props = display->prefetched_initial_properties;
+  display->prefetched_initial_properties = NULL;
+
+  if (props != NULL &&
+      (props->xwindow != window->xwindow ||
+       props->override_redirect != window->override_redirect))
+    {
+      free_initial_properties (props);
+      props = NULL;
+    }
+
+  if (props == NULL)
+    props = request_initial_properties (display, window->xwindow,
+                                        window->override_redirect);
 
-  cobiwm_prop_get_values (window->display, window->xwindow,
-                        values, n_properties);
+  cobiwm_prop_finish_values (props->request);
+  props->request = NULL;
+  values = props->values;
 
   j = 0;
   for (i = 0; i < window->display->n_prop_hooks; i++)
@@ -165,9 +397,7 @@ cobiwm_window_load_initial_properties (CobiwmWindow *window)
         }
     }
 
-  cobiwm_prop_free_values (values, n_properties);
-
-  g_free (values);
+  free_initial_properties (props);
 }
 
 /* Fill in the CobiwmPropValue used to get the value of "property" */
@@ -175,9 +405,18 @@ static void
 init_prop_value (CobiwmWindow          *window,
                  CobiwmWindowPropHooks *hooks,
                  CobiwmPropValue       *value)
+{
+  init_prop_value_for_window (window->override_redirect, hooks, value);
+}
+
+/* Same, for a window which may not have a CobiwmWindow yet */
+static void
+init_prop_value_for_window (gboolean             override_redirect,
+                            CobiwmWindowPropHooks *hooks,
+                            CobiwmPropValue       *value)
 {
   if (!hooks || hooks->type == COBIWM_PROP_VALUE_INVALID ||
-      (window->override_redirect && !(hooks->flags & INCLUDE_OR)))
+      (override_redirect && !(hooks->flags & INCLUDE_OR)))
     {
       value->type = COBIWM_PROP_VALUE_INVALID;
       value->atom = None;
@@ -1886,6 +2125,17 @@ cobiwm_display_init_window_prop_hooks (CobiwmDisplay *display)
 void
 cobiwm_display_free_window_prop_hooks (CobiwmDisplay *display)
 {
+  if (display->property_reload_idle_id)
+    {
+      g_source_remove (display->property_reload_idle_id);
+      display->property_reload_idle_id = 0;
+    }
+  if (display->pending_property_reloads)
+    {
+      g_array_free (display->pending_property_reloads, TRUE);
+      display->pending_property_reloads = NULL;
+    }
+
   g_hash_table_unref (display->prop_hooks);
   display->prop_hooks = NULL;
 
@@ -49,6 +49,32 @@ void cobiwm_window_reload_property_from_xwindow (CobiwmWindow      *window,
                                                Atom             property,
                                                gboolean         initial);
 
+/**
+ * cobiwm_window_queue_property_reload:
+ * @window:    The window.
+ * @xwindow:   The X window to load the property from.
+ * @property:  A single X property atom.
+ *
+ * Like cobiwm_window_reload_property_from_xwindow(), but only remembers
+ * that the property changed.  All the queued properties are fetched
+ * together, and each (window, property) pair only once, by
+ * cobiwm_display_flush_property_reloads(), which also happens on its own
+ * once the pending X events have been handled.
+ */
+void cobiwm_window_queue_property_reload (CobiwmWindow *window,
+                                        Window      xwindow,
+                                        Atom        property);
+
+/**
+ * cobiwm_display_flush_property_reloads:
+ * @display:  The display.
+ *
+ * Fetches and handles all the properties queued by
+ * cobiwm_window_queue_property_reload().  Must be called before handling
+ * anything which may depend on their values.
+ */
+void cobiwm_display_flush_property_reloads (CobiwmDisplay *display);
+
 /**
  * cobiwm_window_load_initial_properties:
  * @window:      The window.
@@ -59,6 +85,31 @@ void cobiwm_window_reload_property_from_xwindow (CobiwmWindow      *window,
  */
 void cobiwm_window_load_initial_properties (CobiwmWindow *window);
 
+/**
+ * cobiwm_window_prefetch_initial_properties:
+ * @display:           The display.
+ * @xwindow:           The X window about to be managed.
+ * @override_redirect: Whether @xwindow is override redirect.
+ *
+ * Sends the requests for the properties loaded by
+ * cobiwm_window_load_initial_properties() without waiting for the
+ * replies, so that they can travel along with other round trips made
+ * while the window is set up.  The next call to
+ * cobiwm_window_load_initial_properties() for @xwindow picks them up.
+ */
+void cobiwm_window_prefetch_initial_properties (CobiwmDisplay *display,
+                                              Window       xwindow,
+                                              gboolean     override_redirect);
+
+/**
+ * cobiwm_window_discard_prefetched_properties:
+ * @display:  The display.
+ *
+ * Drops properties prefetched for a window that is not going to be
+ * managed after all.
+ */
+void cobiwm_window_discard_prefetched_properties (CobiwmDisplay *display);
+
 /**
  * cobiwm_display_init_window_prop_hooks:
  * @display:  The display.
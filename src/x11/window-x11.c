@@ -28,6 +28,7 @@
 #include <string.h>
 #include <X11/Xatom.h>
 #include <X11/Xlibint.h> /* For display->resource_mask */
+#include <X11/Xlib-xcb.h>
 
 #include <X11/extensions/shape.h>
 
@@ -651,6 +652,7 @@ cobiwm_window_x11_unmanage (CobiwmWindow *window)
 
   cobiwm_window_ungrab_keys (window);
   cobiwm_display_ungrab_window_buttons (window->display, window->xwindow);
+  cobiwm_display_forget_lazy_grab_window (window->display, window);
   cobiwm_display_ungrab_focus_window_button (window->display, window);
 
   cobiwm_error_trap_pop (window->display);
@@ -2150,7 +2152,10 @@ process_property_notify (CobiwmWindow     *window,
         xid = window->user_time_window;
     }
 
-  cobiwm_window_reload_property_from_xwindow (window, xid, event->atom, FALSE);
+  /* Fetched along with any other properties changed in the same batch of
+   * events, see events.c:cobiwm_display_handle_xevent()
+   */
+  cobiwm_window_queue_property_reload (window, xid, event->atom);
 
   return TRUE;
 }
@@ -2853,11 +2858,192 @@ wm_state_to_string (int state)
 }
 #endif
 
+/* What cobiwm_window_x11_adopt_windows() already found out about a
+ * window before managing it
+ */
+typedef struct
+{
+  XWindowAttributes attrs;
+  gboolean attrs_valid;
+  /* WM_STATE, if it's set */
+  gboolean has_wm_state;
+  uint32_t wm_state;
+} AdoptedWindowInfo;
+
+static CobiwmWindow *
+window_x11_new_internal (CobiwmDisplay             *display,
+                         Window                   xwindow,
+                         gboolean                 must_be_viewable,
+                         CobiwmCompEffect           effect,
+                         const AdoptedWindowInfo *adopted);
+
 CobiwmWindow *
 cobiwm_window_x11_new (CobiwmDisplay       *display,
                      Window             xwindow,
                      gboolean           must_be_viewable,
                      CobiwmCompEffect     effect)
+{
+  return window_x11_new_internal (display, xwindow, must_be_viewable,
+                                  effect, NULL);
+}
+
+static Visual *
+find_visual (Screen   *xscreen,
+             VisualID  visual_id)
+{
+  int i, j;
+
+  for (i = 0; i < xscreen->ndepths; i++)
+    for (j = 0; j < xscreen->depths[i].nvisuals; j++)
+      if (xscreen->depths[i].visuals[j].visualid == visual_id)
+        return &xscreen->depths[i].visuals[j];
+
+  return NULL;
+}
+
+/* Does what XGetWindowAttributes() does with the replies */
+static void
+fill_window_attributes (CobiwmDisplay                      *display,
+                        xcb_get_window_attributes_reply_t *attrs_reply,
+                        xcb_get_geometry_reply_t          *geometry_reply,
+                        XWindowAttributes                 *attrs)
+{
+  int i;
+
+  attrs->x = geometry_reply->x;
+  attrs->y = geometry_reply->y;
+  attrs->width = geometry_reply->width;
+  attrs->height = geometry_reply->height;
+  attrs->border_width = geometry_reply->border_width;
+  attrs->depth = geometry_reply->depth;
+  attrs->root = geometry_reply->root;
+
+  attrs->class = attrs_reply->_class;
+  attrs->bit_gravity = attrs_reply->bit_gravity;
+  attrs->win_gravity = attrs_reply->win_gravity;
+  attrs->backing_store = attrs_reply->backing_store;
+  attrs->backing_planes = attrs_reply->backing_planes;
+  attrs->backing_pixel = attrs_reply->backing_pixel;
+  attrs->save_under = attrs_reply->save_under;
+  attrs->colormap = attrs_reply->colormap;
+  attrs->map_installed = attrs_reply->map_is_installed;
+  attrs->map_state = attrs_reply->map_state;
+  attrs->all_event_masks = attrs_reply->all_event_masks;
+  attrs->your_event_mask = attrs_reply->your_event_mask;
+  attrs->do_not_propagate_mask = attrs_reply->do_not_propagate_mask;
+  attrs->override_redirect = attrs_reply->override_redirect;
+
+  attrs->screen = NULL;
+  attrs->visual = NULL;
+  for (i = 0; i < ScreenCount (display->xdisplay); i++)
+    {
+      Screen *xscreen = ScreenOfDisplay (display->xdisplay, i);
+
+      if (RootWindowOfScreen (xscreen) == attrs->root)
+        {
+          attrs->screen = xscreen;
+          attrs->visual = find_visual (xscreen, attrs_reply->visual);
+          break;
+        }
+    }
+}
+
+typedef struct
+{
+  xcb_get_window_attributes_cookie_t attrs;
+  xcb_get_geometry_cookie_t geometry;
+  xcb_get_property_cookie_t wm_state;
+} AdoptionCookies;
+
+/**
+ * cobiwm_window_x11_adopt_windows:
+ * @display: a #CobiwmDisplay
+ * @xwindows: (array length=n_windows): windows which already exist
+ * @n_windows: the number of windows in @xwindows
+ *
+ * Manages all the windows in @xwindows which should be managed, as for
+ * cobiwm_window_x11_new() with @must_be_viewable set.  This is for taking
+ * over the windows which were there before us: what needs to be known
+ * about all of them before managing each one is asked for in one go, so
+ * that the time it takes doesn't grow with a round trip per window for
+ * each of those.
+ */
+void
+cobiwm_window_x11_adopt_windows (CobiwmDisplay  *display,
+                               const Window *xwindows,
+                               int           n_windows)
+{
+  xcb_connection_t *xcb_conn = XGetXCBConnection (display->xdisplay);
+  AdoptionCookies *cookies;
+  AdoptedWindowInfo *infos;
+  int i;
+
+  cookies = g_new (AdoptionCookies, n_windows);
+  infos = g_new0 (AdoptedWindowInfo, n_windows);
+
+  for (i = 0; i < n_windows; i++)
+    {
+      cookies[i].attrs = xcb_get_window_attributes (xcb_conn, xwindows[i]);
+      cookies[i].geometry = xcb_get_geometry (xcb_conn, xwindows[i]);
+      cookies[i].wm_state = xcb_get_property (xcb_conn, FALSE, xwindows[i],
+                                              display->atom_WM_STATE,
+                                              display->atom_WM_STATE,
+                                              0, 1);
+    }
+
+  /* Only the first of these has to wait for the server */
+  for (i = 0; i < n_windows; i++)
+    {
+      xcb_get_window_attributes_reply_t *attrs_reply;
+      xcb_get_geometry_reply_t *geometry_reply;
+      xcb_get_property_reply_t *wm_state_reply;
+
+      attrs_reply = xcb_get_window_attributes_reply (xcb_conn, cookies[i].attrs, NULL);
+      geometry_reply = xcb_get_geometry_reply (xcb_conn, cookies[i].geometry, NULL);
+      wm_state_reply = xcb_get_property_reply (xcb_conn, cookies[i].wm_state, NULL);
+
+      if (attrs_reply && geometry_reply)
+        {
+          fill_window_attributes (display, attrs_reply, geometry_reply,
+                                  &infos[i].attrs);
+          infos[i].attrs_valid = TRUE;
+        }
+
+      /* WM_STATE isn't a cardinal, it's type WM_STATE, but is an int */
+      if (wm_state_reply &&
+          wm_state_reply->type == display->atom_WM_STATE &&
+          wm_state_reply->format == 32 &&
+          xcb_get_property_value_length (wm_state_reply) >= 4)
+        {
+          infos[i].has_wm_state = TRUE;
+          infos[i].wm_state = *(uint32_t *) xcb_get_property_value (wm_state_reply);
+        }
+
+      free (attrs_reply);
+      free (geometry_reply);
+      free (wm_state_reply);
+    }
+
+  for (i = 0; i < n_windows; i++)
+    {
+      /* Vanished since; nothing to manage */
+      if (!infos[i].attrs_valid)
+        continue;
+
+      window_x11_new_internal (display, xwindows[i], TRUE,
+                               COBIWM_COMP_EFFECT_NONE, &infos[i]);
+    }
+
+  g_free (cookies);
+  g_free (infos);
+}
+
+static CobiwmWindow *
+window_x11_new_internal (CobiwmDisplay             *display,
+                         Window                   xwindow,
+                         gboolean                 must_be_viewable,
+                         CobiwmCompEffect           effect,
+                         const AdoptedWindowInfo *adopted)
 {
   CobiwmScreen *screen = display->screen;
   XWindowAttributes attrs;
@@ -2883,7 +3069,11 @@ cobiwm_window_x11_new (CobiwmDisplay       *display,
    * so we must be careful with X error handling.
    */
 
-  if (!XGetWindowAttributes (display->xdisplay, xwindow, &attrs))
+  if (adopted)
+    {
+      attrs = adopted->attrs;
+    }
+  else if (!XGetWindowAttributes (display->xdisplay, xwindow, &attrs))
     {
       cobiwm_verbose ("Failed to get attributes for window 0x%lx\n",
                     xwindow);
@@ -2913,12 +3103,23 @@ cobiwm_window_x11_new (CobiwmDisplay       *display,
     {
       /* Only manage if WM_STATE is IconicState or NormalState */
       uint32_t state;
+      gboolean has_state;
 
-      /* WM_STATE isn't a cardinal, it's type WM_STATE, but is an int */
-      if (!(cobiwm_prop_get_cardinal_with_atom_type (display, xwindow,
-                                                   display->atom_WM_STATE,
-                                                   display->atom_WM_STATE,
-                                                   &state) &&
+      if (adopted)
+        {
+          has_state = adopted->has_wm_state;
+          state = adopted->wm_state;
+        }
+      else
+        {
+          /* WM_STATE isn't a cardinal, it's type WM_STATE, but is an int */
+          has_state = cobiwm_prop_get_cardinal_with_atom_type (display, xwindow,
+                                                             display->atom_WM_STATE,
+                                                             display->atom_WM_STATE,
+                                                             &state);
+        }
+
+      if (!(has_state &&
             (state == IconicState || state == NormalState)))
         {
           cobiwm_verbose ("Deciding not to manage unmapped or unviewable window 0x%lx\n", xwindow);
@@ -2966,6 +3167,14 @@ cobiwm_window_x11_new (CobiwmDisplay       *display,
   if (COBIWM_DISPLAY_HAS_SHAPE (display))
     XShapeSelectInput (display->xdisplay, xwindow, ShapeNotifyMask);
 
+  /* Ask for the initial properties now (after selecting for
+   * PropertyNotify, so no change can be missed); the replies come back
+   * with the round trip checking for errors below instead of needing
+   * one of their own.
+   */
+  cobiwm_window_prefetch_initial_properties (display, xwindow,
+                                           attrs.override_redirect);
+
   /* Get rid of any borders */
   if (attrs.border_width != 0)
     XSetWindowBorderWidth (display->xdisplay, xwindow, 0);
@@ -2987,6 +3196,7 @@ cobiwm_window_x11_new (CobiwmDisplay       *display,
     {
       cobiwm_verbose ("Window 0x%lx disappeared just as we tried to manage it\n",
                     xwindow);
+      cobiwm_window_discard_prefetched_properties (display);
       goto error;
     }
 
@@ -3007,7 +3217,9 @@ cobiwm_window_x11_new (CobiwmDisplay       *display,
   cobiwm_window_grab_keys (window);
   if (window->type != COBIWM_WINDOW_DOCK && !window->override_redirect)
     {
-      cobiwm_display_grab_window_buttons (window->display, window->xwindow);
+      /* With lazy grabs, entering the window grabs the buttons */
+      if (!display->key_binding_manager.lazy_window_grabs)
+        cobiwm_display_grab_window_buttons (window->display, window->xwindow);
       cobiwm_display_grab_focus_window_button (window->display, window);
     }
 
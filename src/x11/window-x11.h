@@ -45,6 +45,9 @@ CobiwmWindow * cobiwm_window_x11_new           (CobiwmDisplay        *display,
                                             Window              xwindow,
                                             gboolean            must_be_viewable,
                                             CobiwmCompEffect      effect);
+void         cobiwm_window_x11_adopt_windows (CobiwmDisplay        *display,
+                                            const Window       *xwindows,
+                                            int                 n_windows);
 
 void cobiwm_window_x11_set_net_wm_state            (CobiwmWindow *window);
 void cobiwm_window_x11_set_wm_state                (CobiwmWindow *window);
@@ -831,23 +831,48 @@ latin1_to_utf8 (const char *text)
   return g_string_free (str, FALSE);
 }
 
-void
-cobiwm_prop_get_values (CobiwmDisplay   *display,
-                      Window         xwindow,
-                      CobiwmPropValue *values,
-                      int            n_values)
+struct _CobiwmPropRequest
 {
-  int i;
+  CobiwmDisplay               *display;
+  Window                     xwindow;
+  CobiwmPropValue             *values;
+  int                        n_values;
+  xcb_get_property_cookie_t *tasks;
+};
+
+/**
+ * cobiwm_prop_request_values: (skip)
+ *
+ * Sends the GetProperty requests for @values without waiting for any
+ * reply, so that other requests can be sent (or other work done) before
+ * the replies are collected with cobiwm_prop_finish_values().  @values
+ * must stay alive until then.
+ */
+CobiwmPropRequest *
+cobiwm_prop_request_values (CobiwmDisplay   *display,
+                          Window         xwindow,
+                          CobiwmPropValue *values,
+                          int            n_values)
+{
+  CobiwmPropRequest *request;
   xcb_get_property_cookie_t *tasks;
   xcb_connection_t *xcb_conn = XGetXCBConnection (display->xdisplay);
+  int i;
 
   cobiwm_verbose ("Requesting %d properties of 0x%lx at once\n",
                 n_values, xwindow);
 
+  request = g_new0 (CobiwmPropRequest, 1);
+  request->display = display;
+  request->xwindow = xwindow;
+  request->values = values;
+  request->n_values = n_values;
+
   if (n_values == 0)
-    return;
+    return request;
 
   tasks = g_new0 (xcb_get_property_cookie_t, n_values);
+  request->tasks = tasks;
 
   /* Start up tasks. The "values" array can have values
    * with atom == None, which means to ignore that element.
@@ -911,10 +936,37 @@ cobiwm_prop_get_values (CobiwmDisplay   *display,
       ++i;
     }
 
-  /* Get replies for all our tasks */
-  cobiwm_topic (COBIWM_DEBUG_SYNC, "Syncing to get %d GetProperty replies in %s\n",
+  return request;
+}
+
+/**
+ * cobiwm_prop_finish_values: (skip)
+ *
+ * Waits for the replies to a cobiwm_prop_request_values() and fills in
+ * its values; frees @request.
+ */
+void
+cobiwm_prop_finish_values (CobiwmPropRequest *request)
+{
+  CobiwmDisplay *display = request->display;
+  Window xwindow = request->xwindow;
+  CobiwmPropValue *values = request->values;
+  int n_values = request->n_values;
+  xcb_get_property_cookie_t *tasks = request->tasks;
+  xcb_connection_t *xcb_conn = XGetXCBConnection (display->xdisplay);
+  int i;
+
+  g_free (request);
+
+  if (n_values == 0)
+    return;
+
+  /* The replies come back in the order requested, and xcb flushes the
+   * requests and blocks in xcb_get_property_reply() as needed, so there
+   * is no need for a separate XSync() round trip here.
+   */
+  cobiwm_topic (COBIWM_DEBUG_SYNC, "Waiting for %d GetProperty replies in %s\n",
               n_values, G_STRFUNC);
-  XSync (display->xdisplay, False);
 
   /* Collect results, should arrive in order requested */
   i = 0;
@@ -1047,6 +1099,16 @@ cobiwm_prop_get_values (CobiwmDisplay   *display,
   g_free (tasks);
 }
 
+void
+cobiwm_prop_get_values (CobiwmDisplay   *display,
+                      Window         xwindow,
+                      CobiwmPropValue *values,
+                      int            n_values)
+{
+  cobiwm_prop_finish_values (cobiwm_prop_request_values (display, xwindow,
+                                                     values, n_values));
+}
+
 static void
 free_value (CobiwmPropValue *value)
 {
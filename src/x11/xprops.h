@@ -188,6 +188,17 @@ void cobiwm_prop_get_values (CobiwmDisplay   *display,
                            CobiwmPropValue *values,
                            int            n_values);
 
+/* The same, split in two so that the requests can be sent well before
+ * the replies are needed
+ */
+typedef struct _CobiwmPropRequest CobiwmPropRequest;
+
+CobiwmPropRequest *cobiwm_prop_request_values (CobiwmDisplay   *display,
+                                           Window         xwindow,
+                                           CobiwmPropValue *values,
+                                           int            n_values);
+void cobiwm_prop_finish_values (CobiwmPropRequest *request);
+
 void cobiwm_prop_free_values (CobiwmPropValue *values,
                             int            n_values);
 